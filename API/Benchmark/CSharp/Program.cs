@@ -0,0 +1,72 @@
+﻿/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+using AliFilter;
+using AliFilter.AlignmentFeatures;
+using AliFilter.Models;
+using System.Diagnostics;
+
+namespace AliFilterBenchmark
+{
+    /// <summary>
+    /// Benchmark runner for the C# library (built from the source in this repository). This is run by benchmark.py; see
+    /// the README in the API folder.
+    /// </summary>
+    internal class Program
+    {
+        static int Main(string[] args)
+        {
+            if (args.Length != 4)
+            {
+                Console.Error.WriteLine("Usage: AliFilterBenchmark <alignment file> <model file> <features output> <mask output>");
+                return 64;
+            }
+
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            Alignment alignment = Alignment.FromFile(args[0]);
+            double parseTime = stopwatch.Elapsed.TotalSeconds;
+
+            ValidatedModel model = ValidatedModel.FromFile(args[1]);
+
+            // The other bindings are single-threaded, so the features are computed on a single thread.
+            stopwatch.Restart();
+            double[][] features = Features.DefaultFeatures.ComputeAll(alignment, maxParallelism: 1);
+            Mask mask = model.GetMask(features, defaultParameters: DefaultParameters.Fast, maxParallelism: 1);
+            double computeTime = stopwatch.Elapsed.TotalSeconds;
+
+            using (BinaryWriter writer = new BinaryWriter(File.Create(args[2])))
+            {
+                for (int i = 0; i < features.Length; i++)
+                {
+                    for (int j = 0; j < features[i].Length; j++)
+                    {
+                        writer.Write(features[i][j]);
+                    }
+                }
+            }
+
+            File.WriteAllText(args[3], mask.ToString(MaskType.Binary));
+
+            Console.WriteLine(parseTime.ToString("0.000000000", System.Globalization.CultureInfo.InvariantCulture) + " " + computeTime.ToString("0.000000000", System.Globalization.CultureInfo.InvariantCulture));
+
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,115 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Benchmark runner for the C implementation (the reference for the other bindings). This is compiled and run by
+// benchmark.py; see the README in the API folder.
+//
+// Usage: bench_c <alignment file> <model file> <features output> <mask output>
+//
+// Writes the features (alignmentLength * ALIFILTER_FEATURE_COUNT little-endian doubles) and the mask, and prints the
+// time spent parsing the alignment and computing the features and the mask, in seconds.
+
+#define ALIFILTER_PHYLIP_IMPLEMENTATION
+#define ALIFILTER_FASTA_IMPLEMENTATION
+#define ALIFILTER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../C/fasta.h"
+#include "../C/alifilter.h"
+
+// Current time in seconds (monotonic where available).
+static double getTime(void) {
+#ifdef CLOCK_MONOTONIC
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+int main(int argc, char** argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Usage: %s <alignment file> <model file> <features output> <mask output>\n", argv[0]);
+        return 64;
+    }
+
+    double startTime = getTime();
+
+    alignment sequenceAlignment;
+    int error_code = fasta_parseAlignment(argv[1], &sequenceAlignment);
+
+    if (error_code != 0 && error_code != 5) {
+        fprintf(stderr, "Error reading the alignment (%d)!\n", error_code);
+        return 1;
+    }
+
+    double parseTime = getTime();
+
+    alifilter_model model;
+    error_code = alifilter_parseModel(argv[2], &model);
+
+    if (error_code != 0 && error_code != 5) {
+        fprintf(stderr, "Error reading the model (%d)!\n", error_code);
+        return 1;
+    }
+
+    double modelTime = getTime();
+
+    double* features = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength);
+    double* scores = features == NULL ? NULL : alifilter_getScores(model, features, sequenceAlignment.alignmentLength);
+    char* mask = scores == NULL ? NULL : alifilter_getMaskFromScores(model, scores, sequenceAlignment.alignmentLength);
+
+    double computeTime = getTime();
+
+    if (mask == NULL) {
+        fprintf(stderr, "Not enough memory!\n");
+        return 1;
+    }
+
+    // Write the features and the mask. Doubles are written in the native byte order; all the platforms on which the
+    // benchmark is run are little-endian.
+    FILE* fileH = fopen(argv[3], "wb");
+
+    if (fileH == NULL || fwrite(features, sizeof(double), (size_t)sequenceAlignment.alignmentLength * ALIFILTER_FEATURE_COUNT, fileH) != (size_t)sequenceAlignment.alignmentLength * ALIFILTER_FEATURE_COUNT || fclose(fileH) != 0) {
+        fprintf(stderr, "Error writing the features!\n");
+        return 1;
+    }
+
+    fileH = fopen(argv[4], "wb");
+
+    if (fileH == NULL || fwrite(mask, 1, sequenceAlignment.alignmentLength, fileH) != (size_t)sequenceAlignment.alignmentLength || fclose(fileH) != 0) {
+        fprintf(stderr, "Error writing the mask!\n");
+        return 1;
+    }
+
+    printf("%.9f %.9f\n", parseTime - startTime, computeTime - modelTime);
+
+    free(mask);
+    free(scores);
+    free(features);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return 0;
+}
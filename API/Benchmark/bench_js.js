@@ -0,0 +1,113 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Benchmark runner for the JavaScript implementation (requires Node.js). This is run by benchmark.py; see the README in
+// the API folder.
+//
+// Usage: node bench_js.js <alignment file> <model file> <features output> <mask output>
+
+"use strict";
+
+const fs = require("fs");
+const path = require("path");
+const vm = require("vm");
+
+// alifilter.js is a browser script that defines a global aliFilter object.
+vm.runInThisContext(fs.readFileSync(path.join(__dirname, "..", "JavaScript", "alifilter.js"), "utf8") + "\nglobalThis.aliFilter = aliFilter;");
+
+// Reads an alignment in FASTA or relaxed sequential PHYLIP format, returning an array of sequences.
+function readAlignment(alignmentFile)
+{
+    let text = fs.readFileSync(alignmentFile, "latin1");
+    let sequences = [];
+
+    if (text.trimStart().startsWith(">"))
+    {
+        let current = null;
+
+        for (let line of text.split("\n"))
+        {
+            if (line.startsWith(">"))
+            {
+                if (current !== null)
+                {
+                    sequences.push(current.join(""));
+                }
+
+                current = [];
+            }
+            else if (current !== null)
+            {
+                current.push(line.replace(/\s+/g, ""));
+            }
+        }
+
+        if (current !== null)
+        {
+            sequences.push(current.join(""));
+        }
+    }
+    else
+    {
+        let lines = text.split("\n").filter(line => line.trim().length > 0);
+        let sequenceCount = parseInt(lines[0].trim().split(/\s+/)[0]);
+
+        for (let i = 1; i <= sequenceCount; i++)
+        {
+            let fields = lines[i].trim().split(/\s+/);
+            sequences.push(fields.slice(1).join(""));
+        }
+    }
+
+    return sequences;
+}
+
+if (process.argv.length !== 6)
+{
+    process.stderr.write("Usage: node bench_js.js <alignment file> <model file> <features output> <mask output>\n");
+    process.exit(64);
+}
+
+let startTime = process.hrtime.bigint();
+let sequences = readAlignment(process.argv[2]);
+let parseTime = process.hrtime.bigint();
+
+let model = aliFilter.loadModelFromJSON(fs.readFileSync(process.argv[3], "utf8"));
+
+let modelTime = process.hrtime.bigint();
+let features = aliFilter.getAlignmentFeatures(sequences);
+let mask = model.getMaskFromFeatures(features);
+let computeTime = process.hrtime.bigint();
+
+let featureArray = new Float64Array(features.length * aliFilter.FEATURE_COUNT);
+
+for (let i = 0; i < features.length; i++)
+{
+    for (let j = 0; j < aliFilter.FEATURE_COUNT; j++)
+    {
+        featureArray[i * aliFilter.FEATURE_COUNT + j] = features[i][j];
+    }
+}
+
+fs.writeFileSync(process.argv[4], new Uint8Array(featureArray.buffer));
+fs.writeFileSync(process.argv[5], mask, "latin1");
+
+console.log((Number(parseTime - startTime) * 1e-9).toFixed(9) + " " + (Number(computeTime - modelTime) * 1e-9).toFixed(9));
@@ -0,0 +1,62 @@
+#    AliFilter: A Machine Learning Approach to Alignment Filtering
+#
+#    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+#
+#    Copyright (C) 2024  Giorgio Bianchini
+#
+#    This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, version 3.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Benchmark runner for the Python implementation. This is run by benchmark.py; see the README in the API folder.
+#
+# Usage: python bench_python.py [--numpy] <alignment file> <model file> <features output> <mask output>
+#
+# With --numpy, the NumPy implementation is used even if the native extension module is available.
+
+import os
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Python'))
+
+import numpy
+import alifilter
+
+arguments = sys.argv[1:]
+
+if len(arguments) > 0 and arguments[0] == '--numpy':
+    alifilter._alifilter = None
+    arguments = arguments[1:]
+
+if len(arguments) != 4:
+    sys.stderr.write('Usage: bench_python.py [--numpy] <alignment file> <model file> <features output> <mask output>\n')
+    sys.exit(64)
+
+alignmentFile, modelFile, featuresFile, maskFile = arguments
+
+startTime = time.perf_counter()
+alignment = alifilter.getSequenceMatrix(alifilter._readAlignment(alignmentFile))
+parseTime = time.perf_counter()
+
+model = alifilter.AliFilterModel(modelFile)
+
+modelTime = time.perf_counter()
+features = alifilter.getAlignmentFeatures(alignment)
+mask = model.getMaskFromFeatures(features)
+computeTime = time.perf_counter()
+
+numpy.ascontiguousarray(features, dtype='<f8').tofile(featuresFile)
+
+with open(maskFile, 'w') as fileH:
+    fileH.write(mask)
+
+print('%.9f %.9f' % (parseTime - startTime, computeTime - modelTime))
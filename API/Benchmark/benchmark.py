@@ -0,0 +1,347 @@
+#    AliFilter: A Machine Learning Approach to Alignment Filtering
+#
+#    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+#
+#    Copyright (C) 2024  Giorgio Bianchini
+#
+#    This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, version 3.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Benchmark and conformance harness for the AliFilter API implementations (C, Python, R, JavaScript and C#). Each
+# implementation is run (as a separate process) on the bundled alignments and on randomly generated alignments; the
+# harness records the time spent parsing the alignment and computing the features and mask, the peak memory usage of
+# the process, the maximum deviation of each feature from the C implementation, and the number of mask columns that
+# differ from the C implementation. Implementations whose toolchain is not available are skipped.
+#
+# Usage: python benchmark.py [options] (see python benchmark.py --help)
+
+import argparse
+import json
+import math
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import numpy
+
+benchmarkFolder = os.path.dirname(os.path.abspath(__file__))
+apiFolder = os.path.dirname(benchmarkFolder)
+
+FEATURE_COUNT = 6
+FEATURE_NAMES = [ 'Gaps', 'Identity', 'Distance', 'Entropy', 'Gaps+-1', 'Gaps+-2' ]
+
+# Alignments included in the repository.
+BUNDLED_ALIGNMENTS = [
+    os.path.join(apiFolder, 'C', 'Data', 'example.phy'),
+    os.path.join(apiFolder, 'CSharp', 'Data', 'training1.fas'),
+    os.path.join(apiFolder, 'CSharp', 'Data', 'training2.fas'),
+]
+
+MODEL_FILE = os.path.join(apiFolder, 'C', 'Data', 'alifilter.validated.json')
+
+# Returns the number of sequences in an alignment file (FASTA or relaxed PHYLIP).
+def getSequenceCount(alignmentFile):
+    with open(alignmentFile) as fileH:
+        text = fileH.read()
+    
+    if text.lstrip().startswith('>'):
+        return sum(1 for line in text.splitlines() if line.startswith('>'))
+    else:
+        return int(text.split()[0])
+
+# Generates a random protein alignment with the specified size, including gappy regions (mostly at the ends) and
+# conserved columns, and saves it in FASTA format.
+def generateAlignment(alignmentFile, sequenceCount, alignmentLength, seed):
+    rng = random.Random(seed)
+    residues = 'ACDEFGHIKLMNPQRSTVWY'
+    
+    # Per-column gap probability and conservation.
+    gapProbabilities = []
+    conservation = []
+    
+    for i in range(alignmentLength):
+        distance = min(i, alignmentLength - 1 - i) / max(1, alignmentLength / 2)
+        gapProbabilities.append(min(0.95, 0.6 * math.exp(-10 * distance) + (0.5 if rng.random() < 0.1 else 0.05 * rng.random())))
+        conservation.append((rng.choice(residues), rng.random()))
+    
+    with open(alignmentFile, 'w') as fileH:
+        for s in range(sequenceCount):
+            sequence = []
+            
+            for i in range(alignmentLength):
+                if rng.random() < gapProbabilities[i]:
+                    sequence.append('-')
+                elif rng.random() < conservation[i][1]:
+                    sequence.append(conservation[i][0])
+                else:
+                    sequence.append(rng.choice(residues))
+            
+            fileH.write('>seq%d\n%s\n' % (s + 1, ''.join(sequence)))
+
+# Runs a command, returning its exit code, standard output and error, and peak memory usage (in MiB, or None if this is
+# not available). If the measure program has been compiled, it is used to measure the peak memory usage.
+def runCommand(command, measure, workFolder):
+    if measure is not None:
+        memoryFile = os.path.join(workFolder, 'memory.txt')
+        
+        if os.path.exists(memoryFile):
+            os.remove(memoryFile)
+        
+        completed = subprocess.run([ measure, memoryFile ] + command, capture_output=True)
+        peakMemory = None
+        
+        if os.path.exists(memoryFile):
+            with open(memoryFile) as fileH:
+                peakMemory = int(fileH.read()) / 1024
+    else:
+        completed = subprocess.run(command, capture_output=True)
+        peakMemory = None
+    
+    return completed.returncode, completed.stdout.decode(errors='replace'), completed.stderr.decode(errors='replace'), peakMemory
+
+# Builds the list of implementations whose toolchain is available. Each implementation is a dictionary with a name and
+# a function that returns the command used to run it.
+def getBindings(workFolder, requested):
+    bindings = []
+    skipped = []
+    
+    def wanted(name):
+        return requested is None or name.split(' ')[0] in requested
+    
+    # C (always the reference).
+    compiler = os.environ.get('CC') or shutil.which('gcc') or shutil.which('clang') or shutil.which('cc')
+    
+    if compiler is None:
+        sys.exit('A C compiler is required to compute the reference results!')
+    
+    executable = os.path.join(workFolder, 'bench_c.exe' if os.name == 'nt' else 'bench_c')
+    result = subprocess.run([ compiler, '-O3', os.path.join(benchmarkFolder, 'bench_c.c'), '-o', executable, '-lm' ], capture_output=True)
+    
+    if result.returncode != 0:
+        sys.exit('Error compiling the C benchmark:\n' + result.stderr.decode(errors='replace'))
+    
+    bindings.append({ 'name': 'c', 'command': [ executable ] })
+    
+    # Program used to measure the peak memory usage (POSIX only).
+    measure = None
+    
+    if os.name != 'nt':
+        measure = os.path.join(workFolder, 'measure')
+        
+        if subprocess.run([ compiler, '-O2', os.path.join(benchmarkFolder, 'measure.c'), '-o', measure ], capture_output=True).returncode != 0:
+            measure = None
+    
+    # Python (native extension module, if it has been built, and NumPy).
+    if wanted('python'):
+        script = os.path.join(benchmarkFolder, 'bench_python.py')
+        hasNative = subprocess.run([ sys.executable, '-c', 'import sys; sys.path.insert(0, sys.argv[1]); import alifilter; sys.exit(0 if alifilter._alifilter is not None else 1)', os.path.join(apiFolder, 'Python') ], capture_output=True).returncode == 0
+        
+        if hasNative:
+            bindings.append({ 'name': 'python (native)', 'command': [ sys.executable, script ] })
+        
+        bindings.append({ 'name': 'python (numpy)', 'command': [ sys.executable, script, '--numpy' ] })
+    
+    # R (requires the alifilter package to be installed).
+    if wanted('r'):
+        rscript = shutil.which('Rscript')
+        
+        if rscript is not None:
+            bindings.append({ 'name': 'r', 'command': [ rscript, os.path.join(benchmarkFolder, 'bench_r.R') ] })
+        else:
+            skipped.append('r (Rscript not found)')
+    
+    # JavaScript (Node.js).
+    if wanted('js'):
+        node = shutil.which('node')
+        
+        if node is not None:
+            bindings.append({ 'name': 'js', 'command': [ node, os.path.join(benchmarkFolder, 'bench_js.js') ] })
+        else:
+            skipped.append('js (node not found)')
+    
+    # C# (built from the source in this repository).
+    if wanted('csharp'):
+        dotnet = shutil.which('dotnet')
+        
+        if dotnet is not None:
+            outputFolder = os.path.join(workFolder, 'csharp')
+            
+            # The intermediate files (obj/) of the benchmark and of the AliFilter project it references are also written to
+            # the work folder (one subfolder per project), so that running the benchmark leaves the source tree clean.
+            artifactsFolder = os.path.join(workFolder, 'dotnet')
+            result = subprocess.run([ dotnet, 'build', os.path.join(benchmarkFolder, 'CSharp', 'AliFilterBenchmark.csproj'), '-c', 'Release', '-o', outputFolder, '--artifacts-path', artifactsFolder ], capture_output=True)
+            
+            if result.returncode == 0:
+                bindings.append({ 'name': 'csharp', 'command': [ dotnet, os.path.join(outputFolder, 'AliFilterBenchmark.dll') ] })
+            else:
+                skipped.append('csharp (build failed)')
+        else:
+            skipped.append('csharp (dotnet not found)')
+    
+    return bindings, skipped, measure
+
+# Runs an implementation on an alignment, returning the best times, the peak memory, the features and the mask.
+def runBinding(binding, alignmentFile, workFolder, repeats, measure):
+    featuresFile = os.path.join(workFolder, 'features.bin')
+    maskFile = os.path.join(workFolder, 'mask.txt')
+    
+    parseTimes = []
+    computeTimes = []
+    peakMemory = None
+    
+    for r in range(repeats):
+        returnCode, stdout, stderr, memory = runCommand(binding['command'] + [ alignmentFile, MODEL_FILE, featuresFile, maskFile ], measure, workFolder)
+        
+        if returnCode != 0:
+            return { 'error': (stderr.strip() or stdout.strip() or 'exit code %d' % returnCode).splitlines()[-1] }
+        
+        times = stdout.split()[-2:]
+        parseTimes.append(float(times[0]))
+        computeTimes.append(float(times[1]))
+        
+        if memory is not None:
+            peakMemory = memory if peakMemory is None else max(peakMemory, memory)
+    
+    features = numpy.fromfile(featuresFile, dtype='<f8')
+    
+    with open(maskFile) as fileH:
+        mask = fileH.read().strip()
+    
+    return { 'parseTime': min(parseTimes), 'computeTime': min(computeTimes), 'peakMemory': peakMemory, 'features': features, 'mask': mask }
+
+# Compares the results of an implementation with the reference results.
+def compareResults(result, reference):
+    if len(result['features']) != len(reference['features']) or len(result['mask']) != len(reference['mask']):
+        result['error'] = 'different alignment length'
+        return
+    
+    deviations = numpy.abs(result['features'].reshape(-1, FEATURE_COUNT) - reference['features'].reshape(-1, FEATURE_COUNT))
+    result['featureDeviations'] = deviations.max(axis=0).tolist() if len(deviations) > 0 else [ 0.0 ] * FEATURE_COUNT
+    result['maskDifferences'] = sum(1 for a, b in zip(result['mask'], reference['mask']) if a != b)
+
+def formatNumber(value, format):
+    return '-' if value is None else format % value
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark and conformance harness for the AliFilter API implementations.')
+    parser.add_argument('--bindings', help='comma-separated list of implementations to run, in addition to the C reference (python, r, js, csharp; default: all)')
+    parser.add_argument('--sizes', default='100x5000,1000x20000', help='comma-separated sizes (sequences x columns) of the generated alignments (default: %(default)s; use "" for none)')
+    parser.add_argument('--alignments', nargs='*', help='alignment files to use instead of the bundled alignments')
+    parser.add_argument('--repeats', type=int, default=3, help='number of runs for each implementation and alignment; the fastest time is reported (default: %(default)s)')
+    parser.add_argument('--seed', type=int, default=1, help='seed for the generated alignments (default: %(default)s)')
+    parser.add_argument('--json', help='save the results to this file')
+    parser.add_argument('--baseline', help='compare the times with the results saved (using --json) by a previous run')
+    parser.add_argument('--tolerance', type=float, default=1.2, help='slowdown relative to the baseline that is reported as a regression (default: %(default)s)')
+    args = parser.parse_args()
+    
+    requested = None if args.bindings is None else set(name.strip().lower() for name in args.bindings.split(','))
+    workFolder = tempfile.mkdtemp(prefix='alifilter_benchmark_')
+    
+    try:
+        bindings, skipped, measure = getBindings(workFolder, requested)
+        
+        for name in skipped:
+            print('Skipping ' + name)
+        
+        alignments = list(args.alignments) if args.alignments else [ alignment for alignment in BUNDLED_ALIGNMENTS if os.path.exists(alignment) ]
+        
+        for size in filter(None, args.sizes.split(',')):
+            sequenceCount, alignmentLength = (int(value) for value in size.lower().split('x'))
+            alignmentFile = os.path.join(workFolder, 'generated_%dx%d.fas' % (sequenceCount, alignmentLength))
+            generateAlignment(alignmentFile, sequenceCount, alignmentLength, args.seed)
+            alignments.append(alignmentFile)
+        
+        baseline = {}
+        
+        if args.baseline:
+            with open(args.baseline) as fileH:
+                for row in json.load(fileH):
+                    baseline[(row['alignment'], row['binding'])] = row
+        
+        rows = []
+        regressions = 0
+        
+        print()
+        print('%-26s %-16s %10s %10s %12s %10s %11s %9s%s' % ('Alignment', 'Binding', 'Parse (s)', 'Comp. (s)', 'Mres/s', 'Peak MiB', 'Max dev.', 'Mask diff', '  vs baseline' if baseline else ''))
+        
+        for alignmentFile in alignments:
+            alignmentName = os.path.basename(alignmentFile)
+            residueCount = None
+            reference = None
+            
+            for binding in bindings:
+                result = runBinding(binding, alignmentFile, workFolder, args.repeats, measure)
+                
+                if binding['name'] == 'c':
+                    reference = result
+                    
+                    if 'error' not in result:
+                        residueCount = getSequenceCount(alignmentFile) * len(result['mask'])
+                
+                if 'error' not in result and reference is not None and 'error' not in reference:
+                    compareResults(result, reference)
+                
+                row = { 'alignment': alignmentName, 'binding': binding['name'] }
+                
+                if 'error' in result:
+                    row['error'] = result['error']
+                    print('%-26s %-16s %s' % (alignmentName, binding['name'], 'error: ' + result['error']))
+                    rows.append(row)
+                    continue
+                
+                row.update({ key: result.get(key) for key in ('parseTime', 'computeTime', 'peakMemory', 'maskDifferences') })
+                row['throughput'] = residueCount / result['computeTime'] if residueCount and result['computeTime'] > 0 else None
+                row['featureDeviations'] = dict(zip(FEATURE_NAMES, result.get('featureDeviations', [ None ] * FEATURE_COUNT)))
+                
+                comparison = ''
+                previous = baseline.get((alignmentName, binding['name']))
+                
+                if previous is not None and previous.get('computeTime'):
+                    ratio = result['computeTime'] / previous['computeTime']
+                    comparison = '  %.2fx%s' % (ratio, ' REGRESSION' if ratio > args.tolerance else '')
+                    regressions += ratio > args.tolerance
+                
+                maxDeviation = max(result['featureDeviations']) if 'featureDeviations' in result else None
+                
+                print('%-26s %-16s %10s %10s %12s %10s %11s %9s%s' % (alignmentName, binding['name'], formatNumber(result['parseTime'], '%.4f'), formatNumber(result['computeTime'], '%.4f'),
+                                                                    formatNumber(None if row['throughput'] is None else row['throughput'] / 1e6, '%.2f'), formatNumber(result['peakMemory'], '%.1f'),
+                                                                    formatNumber(maxDeviation, '%.3g'), formatNumber(result.get('maskDifferences'), '%d'), comparison))
+                
+                rows.append(row)
+        
+        print()
+        print('Parse: time to read the alignment (the R implementation reads it together with the features, so its parse')
+        print('time is included in the computation time). Comp.: time to compute the features and the mask. Mres/s:')
+        print('millions of residues (sequences x columns) per second of computation. Peak MiB: maximum resident memory of the')
+        print('process, including the interpreter or runtime (not measured on Windows). Max dev.: maximum absolute deviation of')
+        print('any feature from the C implementation (per-feature values are saved with --json). Mask diff: number of')
+        print('columns whose mask value differs from the C implementation (the C# library preserves columns whose score is')
+        print('greater than the threshold, while the other implementations also preserve columns whose score is equal).')
+        
+        if args.json:
+            with open(args.json, 'w') as fileH:
+                json.dump(rows, fileH, indent=2)
+        
+        if regressions > 0:
+            print()
+            print('%d regression(s) relative to the baseline!' % regressions)
+            return 1
+        
+        return 0
+    finally:
+        shutil.rmtree(workFolder, ignore_errors=True)
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,74 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Runs a command and saves its peak memory usage (maximum resident set size, in KiB) to a file. This is used by
+// benchmark.py on POSIX systems: measuring the benchmark runners directly from Python is not accurate, because on
+// some systems (e.g., Linux) the peak memory usage of a process that has been forked from the Python interpreter
+// starts from the memory usage of the interpreter, while this program is small.
+//
+// Usage: measure <output file> <command> [arguments...]
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <output file> <command> [arguments...]\n", argv[0]);
+        return 64;
+    }
+
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        perror("fork");
+        return 71;
+    }
+    else if (pid == 0) {
+        execvp(argv[2], &argv[2]);
+        perror("execvp");
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return 71;
+    }
+
+    FILE* fileH = fopen(argv[1], "w");
+
+    if (fileH != NULL) {
+#ifdef __APPLE__
+        // ru_maxrss is in bytes on macOS.
+        fprintf(fileH, "%ld\n", (long)(usage.ru_maxrss / 1024));
+#else
+        fprintf(fileH, "%ld\n", (long)usage.ru_maxrss);
+#endif
+        fclose(fileH);
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
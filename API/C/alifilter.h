@@ -45,6 +45,15 @@ typedef struct {
 //                 the features for each column in the alignment. You should free() this pointer eventually.
 double* alifilter_getAlignmentFeatures(const char* sequenceData, int sequenceCount, int alignmentLength);
 
+// Computes the alignment features for an alignment represented by an char array, storing them in a buffer provided by the caller.
+//   Parameters:
+//     • const char* sequenceData: the alignment sequence data (it should contain sequenceCount * alignmentLength elements).
+//     • int sequenceCount: the number of sequences in the alignment.
+//     • int alignmentLength: the length of each sequence in the alignment.
+//     • double* out_features: a pointer to an array containing at least alignmentLength * ALIFILTER_FEATURE_COUNT elements, which
+//                             will be populated with the features for each column in the alignment.
+void alifilter_computeAlignmentFeatures(const char* sequenceData, int sequenceCount, int alignmentLength, double* out_features);
+
 // Parses an AliFilter JSON model file.
 //   Parameters:
 //     • const char* modelFile: the path to the JSON model file.
@@ -70,6 +79,14 @@ int alifilter_parseModel(const char* modelFile, alifilter_model* out_model);
 //                 for each column in the alignment. You should free() this pointer eventually.
 double* alifilter_getScores(alifilter_model model, double* alignmentFeatures, int alignmentLength);
 
+// Computes scores for each alignment column, given pre-computed alignment features for each column, storing them in a buffer provided by the caller.
+//   Parameters:
+//     • alifilter_model model: the model to use.
+//     • const double* alignmentFeatures: the pre-computed alignment features. This should point to an array containing alignmentLength * ALIFILTER_FEATURE_COUNT elements.
+//     • int alignmentLength: number of columns for which alignment features are provided.
+//     • double* out_scores: a pointer to an array containing at least alignmentLength elements, which will be populated with the score for each column.
+void alifilter_computeScores(alifilter_model model, const double* alignmentFeatures, int alignmentLength, double* out_scores);
+
 // Computes an alignment mask, given pre-computed scores for each column.
 //   Parameters:
 //     • alifilter_model model: the model to use.
@@ -79,6 +96,15 @@ double* alifilter_getScores(alifilter_model model, double* alignmentFeatures, in
 //   Return value: a C string containing a sequence of 0s and 1s for columns that should deleted or preserved, respectively.
 char* alifilter_getMaskFromScores(alifilter_model model, double* alignmentScores, int alignmentLength);
 
+// Computes an alignment mask, given pre-computed scores for each column, storing it in a buffer provided by the caller.
+//   Parameters:
+//     • alifilter_model model: the model to use.
+//     • const double* alignmentScores: the pre-computed alignment scores. This should point to an array containing alignmentLength elements.
+//     • int alignmentLength: number of columns for which scores are provided.
+//     • char* out_mask: a pointer to an array containing at least alignmentLength elements, which will be populated with 0s and 1s for
+//                       columns that should deleted or preserved, respectively. No string terminator is added.
+void alifilter_computeMaskFromScores(alifilter_model model, const double* alignmentScores, int alignmentLength, char* out_mask);
+
 // Computes an alignment mask, given pre-computed alignment features for each column.
 //   Parameters:
 //     • alifilter_model model: the model to use.
@@ -102,6 +128,8 @@ char* alifilter_getMask(alifilter_model model, const char* sequenceData, int seq
 
 #include <ctype.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
@@ -167,6 +195,12 @@ double* alifilter_getAlignmentFeatures(const char* sequenceData, int sequenceCou
         return NULL;
     }
 
+    alifilter_computeAlignmentFeatures(sequenceData, sequenceCount, alignmentLength, features);
+
+    return features;
+}
+
+void alifilter_computeAlignmentFeatures(const char* sequenceData, int sequenceCount, int alignmentLength, double* features) {
     // Compute % Gaps, % Identity, Distance from extremity and Entropy.
     for (int i = 0; i < alignmentLength; i++) {
         alifilter_computeColumnFeatures(sequenceData, sequenceCount, alignmentLength, i, &features[i * ALIFILTER_FEATURE_COUNT]);
@@ -188,8 +222,6 @@ double* alifilter_getAlignmentFeatures(const char* sequenceData, int sequenceCou
                                                      (i < alignmentLength - 2 ? features[ALIFILTER_FEATURE_COUNT * (i + 2) + 0] : 0)) /
                                                      (1 + (i > 1 ? 2 : i > 0 ? 1 : 0) + (i < alignmentLength - 2 ? 2 : i < alignmentLength - 1 ? 1 : 0));
     }
-
-    return features;
 }
 
 int alifilter_parseModel(const char* modelFile, alifilter_model* out_model) {
@@ -294,6 +326,12 @@ double* alifilter_getScores(alifilter_model model, double* alignmentFeatures, in
         return NULL;
     }
 
+    alifilter_computeScores(model, alignmentFeatures, alignmentLength, scores);
+
+    return scores;
+}
+
+void alifilter_computeScores(alifilter_model model, const double* alignmentFeatures, int alignmentLength, double* scores) {
     for (int i = 0; i < alignmentLength; i++) {
         scores[i] = model.intercept;
         for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
@@ -301,8 +339,6 @@ double* alifilter_getScores(alifilter_model model, double* alignmentFeatures, in
         }
         scores[i] = 1.0 / (1.0 + exp(-scores[i]));
     }
-
-    return scores;
 }
 
 char* alifilter_getMaskFromScores(alifilter_model model, double* alignmentScores, int alignmentLength) {
@@ -312,15 +348,19 @@ char* alifilter_getMaskFromScores(alifilter_model model, double* alignmentScores
         return NULL;
     }
 
-    for (int i = 0; i < alignmentLength; i++) {
-        mask[i] = (alignmentScores[i] >= model.threshold ? '1' : '0');
-    }
+    alifilter_computeMaskFromScores(model, alignmentScores, alignmentLength, mask);
 
     mask[alignmentLength] = '\0';
 
     return mask;
 }
 
+void alifilter_computeMaskFromScores(alifilter_model model, const double* alignmentScores, int alignmentLength, char* mask) {
+    for (int i = 0; i < alignmentLength; i++) {
+        mask[i] = (alignmentScores[i] >= model.threshold ? '1' : '0');
+    }
+}
+
 char* alifilter_getMaskFromFeatures(alifilter_model model, double* alignmentFeatures, int alignmentLength) {
     double* scores = alifilter_getScores(model, alignmentFeatures, alignmentLength);
 
@@ -0,0 +1,157 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_BATCH_H
+#define ALIFILTER_BATCH_H
+
+// Batch processing of multiple alignments on multiple threads. This requires the implementations from alifilter.h,
+// phylip.h, fasta.h, alifilter_threads.h and alifilter_pyramid.h: define ALIFILTER_IMPLEMENTATION,
+// ALIFILTER_PHYLIP_IMPLEMENTATION, ALIFILTER_FASTA_IMPLEMENTATION, ALIFILTER_THREADS_IMPLEMENTATION and
+// ALIFILTER_PYRAMID_IMPLEMENTATION in the same file as ALIFILTER_BATCH_IMPLEMENTATION.
+
+#include "alifilter.h"
+#include "fasta.h"
+#include "alifilter_threads.h"
+#include "alifilter_pyramid.h"
+
+// Represents an alignment in a batch.
+typedef struct {
+    // Input: path to an alignment file in FASTA or relaxed PHYLIP format, or NULL if the sequence data is provided directly.
+    const char* alignmentFile;
+
+    // Input: the alignment sequence data (only used if alignmentFile is NULL; it should contain sequenceCount * alignmentLength elements).
+    const char* sequenceData;
+
+    // Input: the number of sequences in the alignment (only used if alignmentFile is NULL).
+    int sequenceCount;
+
+    // Input/output: the length of the alignment (if alignmentFile is not NULL, this is set when the file is read).
+    int alignmentLength;
+
+    // Input: path to a file where the feature/score pyramid for the alignment should be saved (see alifilter_pyramid.h),
+    //        or NULL if no pyramid should be built.
+    const char* pyramidFile;
+
+    // Output: a C string containing a sequence of 0s and 1s for columns that should deleted or preserved, respectively,
+    //         or NULL if an error occurred. You should free() this pointer eventually.
+    char* mask;
+
+    // Output:
+    //     • 0: success
+    //     • 1-5: the error code returned by fasta_parseAlignment while reading the alignment file (if the code is 5, the
+    //            mask has still been computed)
+    //     • -1: could not allocate enough memory for the mask
+    //     • -2: error while saving the pyramid (the mask has still been computed)
+    int errorCode;
+} alifilter_batchItem;
+
+// Computes the alignment masks for a batch of alignments, processing multiple alignments in parallel. Alignment files are
+// read by the same threads that compute the masks, so reading one file overlaps with computing the masks for the others.
+//   Parameters:
+//     • alifilter_model model: the model to use.
+//     • alifilter_batchItem* items: the alignments to process. When this function returns, the mask and errorCode fields
+//                                   of each item will have been populated.
+//     • int itemCount: the number of alignments.
+//     • int threadCount: the maximum number of threads to use (if this is less than or equal to 0, one thread per processor
+//                        is used).
+void alifilter_getMasks(alifilter_model model, alifilter_batchItem* items, int itemCount, int threadCount);
+
+#ifdef ALIFILTER_BATCH_IMPLEMENTATION
+
+// State shared by the threads processing a batch.
+typedef struct {
+    alifilter_model model;
+    alifilter_batchItem* items;
+} alifilter_batchState;
+
+// Computes the mask for an alignment, saving the pyramid if necessary.
+static char* alifilter_getBatchMask(alifilter_model model, const char* sequenceData, int sequenceCount, int alignmentLength, const char* pyramidFile, int* out_errorCode) {
+    if (pyramidFile == NULL) {
+        return alifilter_getMask(model, sequenceData, sequenceCount, alignmentLength);
+    }
+
+    // Keep the features and scores, which are needed for the pyramid.
+    double* features = (double*)malloc((size_t)alignmentLength * (ALIFILTER_FEATURE_COUNT + 1) * sizeof(double));
+    char* mask = (char*)malloc(((size_t)alignmentLength + 1) * sizeof(char));
+
+    if (features == NULL || mask == NULL) {
+        free(features);
+        free(mask);
+        return NULL;
+    }
+
+    double* scores = features + (size_t)alignmentLength * ALIFILTER_FEATURE_COUNT;
+
+    alifilter_computeAlignmentFeatures(sequenceData, sequenceCount, alignmentLength, features);
+    alifilter_computeScores(model, features, alignmentLength, scores);
+    alifilter_computeMaskFromScores(model, scores, alignmentLength, mask);
+    mask[alignmentLength] = 0;
+
+    if (alifilter_savePyramid(pyramidFile, features, scores, mask, alignmentLength) != 0) {
+        *out_errorCode = -2;
+    }
+
+    free(features);
+    return mask;
+}
+
+// Computes the mask for a single alignment in the batch.
+static void alifilter_processBatchItem(int index, void* state) {
+    alifilter_batchState* batchState = (alifilter_batchState*)state;
+    alifilter_batchItem* item = &batchState->items[index];
+
+    item->mask = NULL;
+    item->errorCode = 0;
+
+    if (item->alignmentFile != NULL) {
+        alignment sequenceAlignment;
+
+        item->errorCode = fasta_parseAlignment(item->alignmentFile, &sequenceAlignment);
+
+        if (item->errorCode == 0 || item->errorCode == 5) {
+            item->alignmentLength = sequenceAlignment.alignmentLength;
+            item->mask = alifilter_getBatchMask(batchState->model, sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength, item->pyramidFile, &item->errorCode);
+            phylip_freeAlignment(&sequenceAlignment);
+
+            if (item->mask == NULL) {
+                item->errorCode = -1;
+            }
+        }
+    }
+    else {
+        item->mask = alifilter_getBatchMask(batchState->model, item->sequenceData, item->sequenceCount, item->alignmentLength, item->pyramidFile, &item->errorCode);
+
+        if (item->mask == NULL) {
+            item->errorCode = -1;
+        }
+    }
+}
+
+void alifilter_getMasks(alifilter_model model, alifilter_batchItem* items, int itemCount, int threadCount) {
+    alifilter_batchState batchState;
+    batchState.model = model;
+    batchState.items = items;
+
+    alifilter_parallelFor(itemCount, threadCount, alifilter_processBatchItem, &batchState);
+}
+
+#endif
+#endif
@@ -0,0 +1,646 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_BGZF_H
+#define ALIFILTER_BGZF_H
+
+// Writing compressed output (e.g., filtered alignments or masks) in the BGZF format, i.e. a series of independent gzip
+// members each containing at most 64 KiB of data. BGZF files can be read by any gzip decompressor (gzip, zcat, zlib,
+// Python's gzip module, ...) and, since the blocks are independent, they can be compressed in parallel: the writer
+// buffers a batch of blocks, compresses them on multiple threads, and writes them in their original order. The writer
+// can also produce an index in the .gzi format used by bgzip (htslib), which records the compressed and uncompressed
+// offset of each block, so that any block can be read on its own (alifilter_readBGZFBlock).
+//
+// This requires the implementation from alifilter_threads.h and the zlib library (link with -lz).
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alifilter_threads.h"
+#include "phylip.h"
+
+// Maximum number of uncompressed bytes in each block (the same as bgzip).
+#define ALIFILTER_BGZF_BLOCK_SIZE 65280
+
+// Maximum size of a compressed block (including the header and footer).
+#define ALIFILTER_BGZF_MAX_BLOCK_SIZE 65536
+
+// Output formats for alifilter_saveFilteredAlignmentBGZF.
+#define ALIFILTER_FORMAT_FASTA 0
+#define ALIFILTER_FORMAT_PHYLIP 1
+
+// Writes a BGZF file.
+typedef struct {
+    // The output file.
+    FILE* file;
+
+    // Maximum number of threads to use.
+    int threadCount;
+
+    // zlib compression level (0 to 9).
+    int compressionLevel;
+
+    // Number of blocks that are compressed at the same time.
+    int batchBlockCount;
+
+    // Uncompressed data waiting to be compressed (batchBlockCount * ALIFILTER_BGZF_BLOCK_SIZE bytes).
+    unsigned char* input;
+
+    // Number of bytes in the input buffer.
+    size_t inputLength;
+
+    // Compressed blocks (batchBlockCount * ALIFILTER_BGZF_MAX_BLOCK_SIZE bytes).
+    unsigned char* output;
+
+    // Size of each compressed block in the output buffer (0 if compression failed).
+    int* outputLengths;
+
+    // Compressed and uncompressed offsets of the start of each block (2 * blockCount elements).
+    uint64_t* blockOffsets;
+
+    // Number of blocks that have been written.
+    long long blockCount;
+
+    // Number of elements that have been allocated in blockOffsets.
+    long long blockCapacity;
+
+    // Number of compressed and uncompressed bytes written so far.
+    uint64_t compressedOffset;
+    uint64_t uncompressedOffset;
+
+    // 0 if no error has occurred, otherwise the first error code.
+    int error;
+} alifilter_bgzfWriter;
+
+// Creates a BGZF file.
+//   Parameters:
+//     • const char* bgzfFile: the path to the output file.
+//     • int threadCount: the maximum number of threads to use for compression. If this is less than or equal to 0, one
+//                        thread per processor is used.
+//     • int compressionLevel: the zlib compression level (0 to 9, or -1 for the default level).
+//     • alifilter_bgzfWriter* out_writer: if this function returns 0, this will contain the writer (which should be
+//                                         closed using alifilter_closeBGZF).
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 3: could not allocate enough memory for the buffers
+int alifilter_openBGZF(const char* bgzfFile, int threadCount, int compressionLevel, alifilter_bgzfWriter* out_writer);
+
+// Writes data to a BGZF file. The data are buffered, and compressed when enough blocks have been accumulated.
+//   Parameters:
+//     • alifilter_bgzfWriter* writer: the writer.
+//     • const void* data: the data to write.
+//     • size_t length: the number of bytes to write.
+//
+//   Return value:
+//     • 0: success
+//     • 3: could not allocate enough memory for the index
+//     • 4: error while compressing or writing the data
+int alifilter_writeBGZF(alifilter_bgzfWriter* writer, const void* data, size_t length);
+
+// Compresses the remaining data, writes the end-of-file marker, closes the file, and frees the memory used by the writer.
+//   Parameters:
+//     • alifilter_bgzfWriter* writer: the writer.
+//     • const char* indexFile: if this is not NULL, the path to a file where the .gzi index is saved.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the index file
+//     • 3: could not allocate enough memory for the index
+//     • 4: error while compressing or writing the data or the index (or an error that occurred in a previous call to
+//          alifilter_writeBGZF)
+//     • 5: error while closing the file
+int alifilter_closeBGZF(alifilter_bgzfWriter* writer, const char* indexFile);
+
+// Saves an alignment in FASTA or PHYLIP format as a BGZF file, optionally applying a mask.
+//   Parameters:
+//     • const char* bgzfFile: the path to the output file.
+//     • const char* indexFile: if this is not NULL, the path to a file where the .gzi index is saved.
+//     • const alignment* alignment: the alignment.
+//     • const char* mask: if this is not NULL, only the columns for which this contains a '1' are written.
+//     • int format: ALIFILTER_FORMAT_FASTA or ALIFILTER_FORMAT_PHYLIP (in the same layout as the C# library).
+//     • int threadCount: the maximum number of threads to use for compression.
+//
+//   Return value: see alifilter_openBGZF and alifilter_closeBGZF (3 is also returned if there is not enough memory for
+//   the filtered sequences).
+int alifilter_saveFilteredAlignmentBGZF(const char* bgzfFile, const char* indexFile, const alignment* alignment, const char* mask, int format, int threadCount);
+
+// Reads a .gzi index.
+//   Parameters:
+//     • const char* indexFile: the path to the index file.
+//     • uint64_t** out_compressedOffsets: if this function returns 0, this will point to an array containing the offset
+//                                         of each block in the compressed file. You should free() this pointer eventually.
+//     • uint64_t** out_uncompressedOffsets: if this function returns 0, this will point to an array containing the offset
+//                                           of each block in the uncompressed data. You should free() this pointer eventually.
+//     • long long* out_blockCount: if this function returns 0, this will contain the number of blocks in the index.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the file is not a valid index
+//     • 3: could not allocate enough memory for the index
+//     • 4: error while reading the file
+int alifilter_readBGZFIndex(const char* indexFile, uint64_t** out_compressedOffsets, uint64_t** out_uncompressedOffsets, long long* out_blockCount);
+
+// Reads and decompresses a single block from a BGZF file.
+//   Parameters:
+//     • const char* bgzfFile: the path to the BGZF file.
+//     • uint64_t compressedOffset: the offset of the block in the file (e.g., from alifilter_readBGZFIndex).
+//     • unsigned char* out_data: a buffer containing at least ALIFILTER_BGZF_MAX_BLOCK_SIZE bytes, which will contain the
+//                                uncompressed data.
+//     • int* out_length: if this function returns 0, this will contain the number of uncompressed bytes.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the data at the specified offset is not a valid BGZF block
+//     • 3: could not allocate enough memory
+//     • 4: error while reading the file
+int alifilter_readBGZFBlock(const char* bgzfFile, uint64_t compressedOffset, unsigned char* out_data, int* out_length);
+
+#ifdef ALIFILTER_BGZF_IMPLEMENTATION
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifndef MAX
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#endif
+
+#ifndef MIN
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+// Size of the gzip header of a BGZF block (including the BC extra field) and of the footer (CRC32 and input size).
+#define ALIFILTER_BGZF_HEADER_SIZE 18
+#define ALIFILTER_BGZF_FOOTER_SIZE 8
+
+// Seeks to a 64-bit offset from the start of the file. Outside Windows this only uses ISO C fseek (so that it works
+// regardless of the feature-test macros and of the size of off_t), moving forward in steps of at most LONG_MAX bytes.
+//   Return value: 0 on success, non-zero on failure.
+static int alifilter_bgzf_seek(FILE* fileH, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(fileH, (__int64)offset, SEEK_SET);
+#else
+    if (fseek(fileH, 0, SEEK_SET) != 0) {
+        return 1;
+    }
+
+    while (offset > 0) {
+        long step = offset > (uint64_t)LONG_MAX ? LONG_MAX : (long)offset;
+
+        if (fseek(fileH, step, SEEK_CUR) != 0) {
+            return 1;
+        }
+
+        offset -= (uint64_t)step;
+    }
+
+    return 0;
+#endif
+}
+
+// The end-of-file marker (an empty block).
+static const unsigned char alifilter_bgzf_eof[28] = { 0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 0x06, 0, 'B', 'C', 0x02, 0, 0x1b, 0, 0x03, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// Stores an unsigned integer of the specified size in little-endian order.
+static void alifilter_bgzf_putUInt(unsigned char* target, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        target[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// Reads an unsigned integer of the specified size in little-endian order.
+static uint64_t alifilter_bgzf_getUInt(const unsigned char* source, int size) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < size; i++) {
+        value |= (uint64_t)source[i] << (8 * i);
+    }
+
+    return value;
+}
+
+// Compresses a block of data into a BGZF block.
+//   Return value: the size of the compressed block, or 0 if an error occurred.
+static int alifilter_bgzf_compressBlock(const unsigned char* data, int length, int compressionLevel, unsigned char* out_block) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // Raw deflate data (negative window bits), since the gzip header is written here.
+    if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return 0;
+    }
+
+    stream.next_in = (Bytef*)data;
+    stream.avail_in = (uInt)length;
+    stream.next_out = out_block + ALIFILTER_BGZF_HEADER_SIZE;
+    stream.avail_out = ALIFILTER_BGZF_MAX_BLOCK_SIZE - ALIFILTER_BGZF_HEADER_SIZE - ALIFILTER_BGZF_FOOTER_SIZE;
+
+    int result = deflate(&stream, Z_FINISH);
+    int compressedLength = (int)stream.total_out;
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        // Incompressible data: store it without compression (this always fits, since blocks are smaller than 64 KiB).
+        if (compressionLevel == 0) {
+            return 0;
+        }
+
+        return alifilter_bgzf_compressBlock(data, length, 0, out_block);
+    }
+
+    int blockSize = ALIFILTER_BGZF_HEADER_SIZE + compressedLength + ALIFILTER_BGZF_FOOTER_SIZE;
+
+    // gzip header with the BC extra field, which contains the block size minus 1.
+    static const unsigned char header[16] = { 0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 0x06, 0, 'B', 'C', 0x02, 0 };
+    memcpy(out_block, header, 16);
+    alifilter_bgzf_putUInt(out_block + 16, (uint64_t)(blockSize - 1), 2);
+
+    alifilter_bgzf_putUInt(out_block + ALIFILTER_BGZF_HEADER_SIZE + compressedLength, crc32(crc32(0L, Z_NULL, 0), data, (uInt)length), 4);
+    alifilter_bgzf_putUInt(out_block + ALIFILTER_BGZF_HEADER_SIZE + compressedLength + 4, (uint64_t)length, 4);
+
+    return blockSize;
+}
+
+// Compresses one of the blocks in the input buffer (body of alifilter_parallelFor).
+static void alifilter_bgzf_compressBatchBlock(int block, void* state) {
+    alifilter_bgzfWriter* writer = (alifilter_bgzfWriter*)state;
+
+    size_t start = (size_t)block * ALIFILTER_BGZF_BLOCK_SIZE;
+    int length = (int)MIN((size_t)ALIFILTER_BGZF_BLOCK_SIZE, writer->inputLength - start);
+
+    writer->outputLengths[block] = alifilter_bgzf_compressBlock(writer->input + start, length, writer->compressionLevel, writer->output + (size_t)block * ALIFILTER_BGZF_MAX_BLOCK_SIZE);
+}
+
+// Compresses the data in the input buffer and writes the blocks to the file, in order.
+//   Return value: 0 on success, 3 if there is not enough memory for the index, 4 if an error occurred.
+static int alifilter_bgzf_flush(alifilter_bgzfWriter* writer) {
+    if (writer->inputLength == 0) {
+        return 0;
+    }
+
+    int blockCount = (int)((writer->inputLength + ALIFILTER_BGZF_BLOCK_SIZE - 1) / ALIFILTER_BGZF_BLOCK_SIZE);
+
+    if (writer->blockCount + blockCount > writer->blockCapacity) {
+        long long newCapacity = MAX(writer->blockCapacity * 2, writer->blockCount + blockCount);
+        uint64_t* newOffsets = (uint64_t*)realloc(writer->blockOffsets, (size_t)newCapacity * 2 * sizeof(uint64_t));
+
+        if (newOffsets == NULL) {
+            return 3;
+        }
+
+        writer->blockOffsets = newOffsets;
+        writer->blockCapacity = newCapacity;
+    }
+
+    alifilter_parallelFor(blockCount, writer->threadCount, alifilter_bgzf_compressBatchBlock, writer);
+
+    for (int i = 0; i < blockCount; i++) {
+        if (writer->outputLengths[i] == 0 || fwrite(writer->output + (size_t)i * ALIFILTER_BGZF_MAX_BLOCK_SIZE, 1, writer->outputLengths[i], writer->file) != (size_t)writer->outputLengths[i]) {
+            return 4;
+        }
+
+        writer->blockOffsets[2 * writer->blockCount] = writer->compressedOffset;
+        writer->blockOffsets[2 * writer->blockCount + 1] = writer->uncompressedOffset;
+        writer->blockCount++;
+
+        writer->compressedOffset += writer->outputLengths[i];
+        writer->uncompressedOffset += MIN((size_t)ALIFILTER_BGZF_BLOCK_SIZE, writer->inputLength - (size_t)i * ALIFILTER_BGZF_BLOCK_SIZE);
+    }
+
+    writer->inputLength = 0;
+
+    return 0;
+}
+
+int alifilter_openBGZF(const char* bgzfFile, int threadCount, int compressionLevel, alifilter_bgzfWriter* out_writer) {
+    memset(out_writer, 0, sizeof(alifilter_bgzfWriter));
+
+    out_writer->threadCount = threadCount > 0 ? threadCount : alifilter_getProcessorCount();
+    out_writer->compressionLevel = compressionLevel < 0 || compressionLevel > 9 ? Z_DEFAULT_COMPRESSION : compressionLevel;
+
+    // A few blocks for each thread in each batch, so that uneven compression times even out between the threads. The
+    // blocks are compressed and then written, one batch at a time.
+    out_writer->batchBlockCount = 4 * out_writer->threadCount;
+
+    out_writer->input = (unsigned char*)malloc((size_t)out_writer->batchBlockCount * ALIFILTER_BGZF_BLOCK_SIZE);
+    out_writer->output = (unsigned char*)malloc((size_t)out_writer->batchBlockCount * ALIFILTER_BGZF_MAX_BLOCK_SIZE);
+    out_writer->outputLengths = (int*)malloc((size_t)out_writer->batchBlockCount * sizeof(int));
+
+    if (out_writer->input == NULL || out_writer->output == NULL || out_writer->outputLengths == NULL) {
+        free(out_writer->input);
+        free(out_writer->output);
+        free(out_writer->outputLengths);
+        return 3;
+    }
+
+    out_writer->file = fopen(bgzfFile, "wb");
+    if (out_writer->file == NULL) {
+        free(out_writer->input);
+        free(out_writer->output);
+        free(out_writer->outputLengths);
+        return 1;
+    }
+
+    return 0;
+}
+
+int alifilter_writeBGZF(alifilter_bgzfWriter* writer, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t capacity = (size_t)writer->batchBlockCount * ALIFILTER_BGZF_BLOCK_SIZE;
+
+    while (length > 0 && writer->error == 0) {
+        size_t chunk = MIN(length, capacity - writer->inputLength);
+        memcpy(writer->input + writer->inputLength, bytes, chunk);
+        writer->inputLength += chunk;
+        bytes += chunk;
+        length -= chunk;
+
+        if (writer->inputLength == capacity) {
+            writer->error = alifilter_bgzf_flush(writer);
+        }
+    }
+
+    return writer->error;
+}
+
+// Writes the .gzi index: the number of entries, followed by the compressed and uncompressed offset of each block except
+// the first one (which always starts at 0).
+static int alifilter_bgzf_saveIndex(const alifilter_bgzfWriter* writer, const char* indexFile) {
+    FILE* fileH = fopen(indexFile, "wb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char buffer[16];
+    long long entryCount = MAX(writer->blockCount - 1, 0);
+
+    alifilter_bgzf_putUInt(buffer, (uint64_t)entryCount, 8);
+    int ok = fwrite(buffer, 1, 8, fileH) == 8;
+
+    for (long long i = 1; i < writer->blockCount && ok; i++) {
+        alifilter_bgzf_putUInt(buffer, writer->blockOffsets[2 * i], 8);
+        alifilter_bgzf_putUInt(buffer + 8, writer->blockOffsets[2 * i + 1], 8);
+        ok = fwrite(buffer, 1, 16, fileH) == 16;
+    }
+
+    int result = ok ? 0 : 4;
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+int alifilter_closeBGZF(alifilter_bgzfWriter* writer, const char* indexFile) {
+    int result = writer->error;
+
+    if (result == 0) {
+        result = alifilter_bgzf_flush(writer);
+    }
+
+    if (result == 0 && fwrite(alifilter_bgzf_eof, 1, sizeof(alifilter_bgzf_eof), writer->file) != sizeof(alifilter_bgzf_eof)) {
+        result = 4;
+    }
+
+    if (fclose(writer->file) != 0 && result == 0) {
+        result = 5;
+    }
+
+    if (result == 0 && indexFile != NULL) {
+        result = alifilter_bgzf_saveIndex(writer, indexFile);
+    }
+
+    free(writer->input);
+    free(writer->output);
+    free(writer->outputLengths);
+    free(writer->blockOffsets);
+    memset(writer, 0, sizeof(alifilter_bgzfWriter));
+
+    return result;
+}
+
+int alifilter_saveFilteredAlignmentBGZF(const char* bgzfFile, const char* indexFile, const alignment* alignment, const char* mask, int format, int threadCount) {
+    // Buffer for a line of the output (the longest sequence name, a space, the filtered sequence and a newline).
+    char* line = (char*)malloc((size_t)alignment->alignmentLength + MAX_SEQUENCE_NAME_LENGTH + 3);
+
+    if (line == NULL) {
+        return 3;
+    }
+
+    alifilter_bgzfWriter writer;
+    int result = alifilter_openBGZF(bgzfFile, threadCount, -1, &writer);
+
+    if (result != 0) {
+        free(line);
+        return result;
+    }
+
+    int filteredLength = 0;
+
+    for (int j = 0; j < alignment->alignmentLength; j++) {
+        if (mask == NULL || mask[j] == '1') {
+            filteredLength++;
+        }
+    }
+
+    int maxNameLength = 0;
+
+    for (int i = 0; i < alignment->sequenceCount; i++) {
+        maxNameLength = MAX(maxNameLength, (int)strlen(phylip_getSequenceName(alignment, i)));
+    }
+
+    if (format == ALIFILTER_FORMAT_PHYLIP) {
+        int length = sprintf(line, "%d  %d\n", alignment->sequenceCount, filteredLength);
+        alifilter_writeBGZF(&writer, line, length);
+    }
+
+    for (int i = 0; i < alignment->sequenceCount; i++) {
+        const char* name = phylip_getSequenceName(alignment, i);
+        const char* sequence = alignment->sequenceData + (size_t)i * alignment->alignmentLength;
+        int length = 0;
+
+        if (format == ALIFILTER_FORMAT_PHYLIP) {
+            length = sprintf(line, "%s", name);
+
+            while (length <= maxNameLength) {
+                line[length++] = ' ';
+            }
+        }
+        else {
+            length = sprintf(line, ">%s\n", name);
+        }
+
+        for (int j = 0; j < alignment->alignmentLength; j++) {
+            if (mask == NULL || mask[j] == '1') {
+                line[length++] = sequence[j];
+            }
+        }
+
+        line[length++] = '\n';
+
+        if (alifilter_writeBGZF(&writer, line, length) != 0) {
+            break;
+        }
+    }
+
+    free(line);
+
+    return alifilter_closeBGZF(&writer, indexFile);
+}
+
+int alifilter_readBGZFIndex(const char* indexFile, uint64_t** out_compressedOffsets, uint64_t** out_uncompressedOffsets, long long* out_blockCount) {
+    FILE* fileH = fopen(indexFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char buffer[16];
+    int result = 0;
+
+    if (fread(buffer, 1, 8, fileH) != 8) {
+        result = ferror(fileH) ? 4 : 2;
+    }
+
+    uint64_t entryCount = result == 0 ? alifilter_bgzf_getUInt(buffer, 8) : 0;
+
+    if (result == 0 && entryCount >= (uint64_t)1 << 40) {
+        result = 2;
+    }
+
+    uint64_t* compressedOffsets = NULL;
+    uint64_t* uncompressedOffsets = NULL;
+
+    if (result == 0) {
+        compressedOffsets = (uint64_t*)malloc((size_t)(entryCount + 1) * sizeof(uint64_t));
+        uncompressedOffsets = (uint64_t*)malloc((size_t)(entryCount + 1) * sizeof(uint64_t));
+
+        if (compressedOffsets == NULL || uncompressedOffsets == NULL) {
+            result = 3;
+        }
+    }
+
+    if (result == 0) {
+        // The first block is not included in the index.
+        compressedOffsets[0] = 0;
+        uncompressedOffsets[0] = 0;
+
+        for (uint64_t i = 1; i <= entryCount && result == 0; i++) {
+            if (fread(buffer, 1, 16, fileH) != 16) {
+                result = ferror(fileH) ? 4 : 2;
+            }
+            else {
+                compressedOffsets[i] = alifilter_bgzf_getUInt(buffer, 8);
+                uncompressedOffsets[i] = alifilter_bgzf_getUInt(buffer + 8, 8);
+            }
+        }
+    }
+
+    fclose(fileH);
+
+    if (result == 0) {
+        *out_compressedOffsets = compressedOffsets;
+        *out_uncompressedOffsets = uncompressedOffsets;
+        *out_blockCount = (long long)entryCount + 1;
+    }
+    else {
+        free(compressedOffsets);
+        free(uncompressedOffsets);
+    }
+
+    return result;
+}
+
+int alifilter_readBGZFBlock(const char* bgzfFile, uint64_t compressedOffset, unsigned char* out_data, int* out_length) {
+    FILE* fileH = fopen(bgzfFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char* block = (unsigned char*)malloc(ALIFILTER_BGZF_MAX_BLOCK_SIZE);
+    int result = block == NULL ? 3 : 0;
+
+    if (result == 0 && alifilter_bgzf_seek(fileH, compressedOffset) != 0) {
+        result = 4;
+    }
+
+    if (result == 0 && fread(block, 1, ALIFILTER_BGZF_HEADER_SIZE, fileH) != ALIFILTER_BGZF_HEADER_SIZE) {
+        result = ferror(fileH) ? 4 : 2;
+    }
+
+    // Check the gzip header and the BC extra field.
+    if (result == 0 && (block[0] != 0x1f || block[1] != 0x8b || block[2] != 0x08 || block[3] != 0x04 || alifilter_bgzf_getUInt(block + 10, 2) != 6 ||
+        block[12] != 'B' || block[13] != 'C' || alifilter_bgzf_getUInt(block + 14, 2) != 2)) {
+        result = 2;
+    }
+
+    int blockSize = result == 0 ? (int)alifilter_bgzf_getUInt(block + 16, 2) + 1 : 0;
+
+    if (result == 0 && blockSize < ALIFILTER_BGZF_HEADER_SIZE + ALIFILTER_BGZF_FOOTER_SIZE) {
+        result = 2;
+    }
+
+    if (result == 0 && fread(block + ALIFILTER_BGZF_HEADER_SIZE, 1, blockSize - ALIFILTER_BGZF_HEADER_SIZE, fileH) != (size_t)(blockSize - ALIFILTER_BGZF_HEADER_SIZE)) {
+        result = ferror(fileH) ? 4 : 2;
+    }
+
+    if (result == 0) {
+        uint64_t expectedCRC = alifilter_bgzf_getUInt(block + blockSize - 8, 4);
+        int expectedLength = (int)alifilter_bgzf_getUInt(block + blockSize - 4, 4);
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+
+        if (expectedLength > ALIFILTER_BGZF_MAX_BLOCK_SIZE || inflateInit2(&stream, -15) != Z_OK) {
+            result = 2;
+        }
+        else {
+            stream.next_in = block + ALIFILTER_BGZF_HEADER_SIZE;
+            stream.avail_in = (uInt)(blockSize - ALIFILTER_BGZF_HEADER_SIZE - ALIFILTER_BGZF_FOOTER_SIZE);
+            stream.next_out = out_data;
+            stream.avail_out = ALIFILTER_BGZF_MAX_BLOCK_SIZE;
+
+            if (inflate(&stream, Z_FINISH) != Z_STREAM_END || (int)stream.total_out != expectedLength ||
+                crc32(crc32(0L, Z_NULL, 0), out_data, (uInt)stream.total_out) != expectedCRC) {
+                result = 2;
+            }
+            else {
+                *out_length = expectedLength;
+            }
+
+            inflateEnd(&stream);
+        }
+    }
+
+    free(block);
+    fclose(fileH);
+
+    return result;
+}
+
+#endif
+#endif
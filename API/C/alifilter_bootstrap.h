@@ -0,0 +1,791 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_BOOTSTRAP_H
+#define ALIFILTER_BOOTSTRAP_H
+
+// Poisson bootstrap for the "accurate" mode, which does not need random access to the alignment. Instead of resampling
+// the sequences, each sequence is given an independent Poisson(1) weight in each bootstrap replicate; the weights are
+// drawn from a counter-based generator keyed by the sequence index, so they do not depend on the order in which
+// sequences are added or on how the alignment is split. The weighted residue counts of each column are accumulated in
+// one count table per replicate, which means that:
+//     • the sequences can be streamed, one at a time, in a single pass;
+//     • the alignment can be split into shards of sequences (e.g., on different machines), each accumulated separately
+//       and then merged (alifilter_mergeBootstrap), with the same results as accumulating everything together;
+//     • the columns can be split into blocks, so that the count tables fit in memory.
+//
+// The count tables take (replicateCount + 1) * (columnCount + 4) * ALIFILTER_BOOTSTRAP_CLASS_COUNT * 4 bytes. Since the
+// weights are independent, the total weight of a replicate is not exactly the number of sequences; the features for
+// each replicate are normalised by its total weight.
+//
+// Each column has a reference class (the class of the first residue added to it), which is not counted explicitly:
+// its count is the total weight minus the counts of the other classes. Therefore, residues that match the reference
+// cost nothing to accumulate. Columns where all the residues are in the same class (e.g., all gaps, or a single
+// nucleotide) have the same features in every replicate, so their score is only computed once, and for the columns
+// next to them only the windowed gap features are recomputed for each replicate.
+//
+// This requires the implementations from alifilter.h and alifilter_threads.h.
+
+#include "alifilter.h"
+#include "alifilter_threads.h"
+
+// Number of residue classes in the count tables: gaps, the letters A-Z (case insensitive), and everything else.
+#define ALIFILTER_BOOTSTRAP_CLASS_COUNT 28
+
+// Accumulates the weighted residue counts for a set of bootstrap replicates.
+typedef struct {
+    // Number of bootstrap replicates.
+    int replicateCount;
+
+    // Seed for the bootstrap weights (accumulators with different seeds cannot be merged).
+    unsigned long long seed;
+
+    // Total length of the alignment.
+    int alignmentLength;
+
+    // First column for which the mask is computed.
+    int firstColumn;
+
+    // Number of columns for which the mask is computed.
+    int columnCount;
+
+    // First column in the count tables (the tables also contain up to two columns on either side of the requested
+    // columns, which are needed for the windowed gap features).
+    int firstTableColumn;
+
+    // Number of columns in the count tables.
+    int tableColumnCount;
+
+    // Number of sequences that have been added.
+    long long sequenceCount;
+
+    // Total weight of each replicate (replicateCount + 1 elements; element 0 is the original alignment, where each
+    // sequence has weight 1).
+    unsigned long long* totalWeights;
+
+    // Count tables ((replicateCount + 1) * tableColumnCount * ALIFILTER_BOOTSTRAP_CLASS_COUNT elements, indexed as
+    // [column][replicate][class]; replicate 0 is the original alignment). The counts for all the replicates of a column
+    // are contiguous, so that adding a block of sequences reads and writes them sequentially. The count for the
+    // reference class of each column is always 0.
+    unsigned int* counts;
+
+    // Reference class for each column in the count tables (tableColumnCount elements; 255 until the first sequence has
+    // been added).
+    unsigned char* referenceClasses;
+
+    // Residue class for each character.
+    unsigned char classes[256];
+} alifilter_bootstrap;
+
+// Reads the settings for the "accurate" mode from a validated AliFilter JSON model file. The model itself should be read
+// using alifilter_parseModel.
+//   Parameters:
+//     • const char* modelFile: the path to the JSON model file.
+//     • double* out_threshold: when this function returns 0, this will contain the threshold for the logistic model in
+//                              each bootstrap replicate (use this as the threshold of the alifilter_model).
+//     • double* out_bootstrapThreshold: when this function returns 0, this will contain the bootstrap threshold.
+//     • int* out_replicateCount: when this function returns 0, this will contain the number of bootstrap replicates.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 3: the file does not contain the settings for the accurate mode (e.g., because the model has not been validated)
+int alifilter_parseAccurateSettings(const char* modelFile, double* out_threshold, double* out_bootstrapThreshold, int* out_replicateCount);
+
+// Initialises a bootstrap accumulator.
+//   Parameters:
+//     • alifilter_bootstrap* out_bootstrap: the accumulator to initialise (it should be freed using alifilter_freeBootstrap).
+//     • int alignmentLength: the total length of the alignment.
+//     • int firstColumn: the first column for which the mask should be computed.
+//     • int columnCount: the number of columns for which the mask should be computed (e.g., alignmentLength - firstColumn).
+//     • int replicateCount: the number of bootstrap replicates.
+//     • unsigned long long seed: the seed for the bootstrap weights.
+//
+//   Return value:
+//     • 0: success
+//     • 2: invalid parameters
+//     • 3: could not allocate enough memory
+int alifilter_initBootstrap(alifilter_bootstrap* out_bootstrap, int alignmentLength, int firstColumn, int columnCount, int replicateCount, unsigned long long seed);
+
+// Frees the memory used by a bootstrap accumulator.
+void alifilter_freeBootstrap(alifilter_bootstrap* bootstrap);
+
+// Gets the Poisson(1) weight of a sequence in a bootstrap replicate. This only depends on the arguments.
+//   Parameters:
+//     • unsigned long long seed: the seed for the bootstrap weights.
+//     • long long sequenceIndex: the index of the sequence in the alignment.
+//     • int replicate: the index of the bootstrap replicate (starting from 0).
+unsigned int alifilter_getBootstrapWeight(unsigned long long seed, long long sequenceIndex, int replicate);
+
+// Adds a block of consecutive sequences to a bootstrap accumulator. Adding sequences in blocks (e.g., of 64 sequences)
+// is much faster than adding them one at a time, because the count tables are traversed once per block.
+//   Parameters:
+//     • alifilter_bootstrap* bootstrap: the accumulator.
+//     • const char* sequenceData: the sequences (this should contain sequenceCount * alignmentLength elements, even if
+//                                 the accumulator only covers some of the columns).
+//     • int sequenceCount: the number of sequences in the block.
+//     • long long firstSequenceIndex: the index of the first sequence of the block in the whole alignment. Each sequence
+//                                     must be added exactly once, with the same index, to exactly one of the
+//                                     accumulators that are merged.
+//
+//   Return value: 0 on success, or 3 if there was not enough memory (in which case nothing has been added).
+int alifilter_addBootstrapSequences(alifilter_bootstrap* bootstrap, const char* sequenceData, int sequenceCount, long long firstSequenceIndex);
+
+// Adds the counts from another accumulator (e.g., one for a different shard of sequences) to an accumulator.
+//   Return value: 0 on success, or 2 if the accumulators do not have the same alignment length, columns, number of
+//                 replicates and seed.
+int alifilter_mergeBootstrap(alifilter_bootstrap* target, const alifilter_bootstrap* source);
+
+// Saves the state of an accumulator to a file (e.g., to merge it on a different machine).
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 4: error while writing the file
+//     • 5: error while closing the file
+int alifilter_saveBootstrap(const char* bootstrapFile, const alifilter_bootstrap* bootstrap);
+
+// Loads the state of an accumulator from a file created by alifilter_saveBootstrap.
+//   Parameters:
+//     • const char* bootstrapFile: the path to the file.
+//     • alifilter_bootstrap* out_bootstrap: if the return value is 0 or 5, when this function returns this will contain
+//                                           the accumulator (which should be freed using alifilter_freeBootstrap).
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the file is not a valid bootstrap file
+//     • 3: could not allocate enough memory
+//     • 4: error while reading the file
+//     • 5: error while closing the file (but the accumulator has been read successfully and should be freed)
+int alifilter_loadBootstrap(const char* bootstrapFile, alifilter_bootstrap* out_bootstrap);
+
+// Computes the features of the original alignment (replicate 0) or of a bootstrap replicate (1 to replicateCount), for
+// the columns covered by the accumulator.
+//   Parameters:
+//     • const alifilter_bootstrap* bootstrap: the accumulator.
+//     • int replicate: 0 for the original alignment, or the index of the bootstrap replicate plus 1.
+//     • double* out_features: a pointer to an array containing at least columnCount * ALIFILTER_FEATURE_COUNT elements,
+//                             which will be populated with the features for each column. For the original alignment,
+//                             these are identical to the ones computed by alifilter_computeAlignmentFeatures.
+void alifilter_computeBootstrapFeatures(const alifilter_bootstrap* bootstrap, int replicate, double* out_features);
+
+// Computes the bootstrap mask for the columns covered by the accumulator. A column is preserved in a replicate if its
+// score is greater than or equal to the model threshold; it is preserved in the final mask if the proportion of
+// replicates in which it is preserved is greater than the bootstrap threshold (as in the C# library).
+//   Parameters:
+//     • const alifilter_bootstrap* bootstrap: the accumulator.
+//     • alifilter_model model: the model (its threshold should be the one for the accurate mode).
+//     • double bootstrapThreshold: the bootstrap threshold.
+//     • int threadCount: the maximum number of threads to use (if this is less than or equal to 0, one thread per processor is used).
+//     • double* out_support: if this is not NULL, a pointer to an array containing at least columnCount elements, which will
+//                            be populated with the proportion of replicates in which each column is preserved.
+//     • char* out_mask: a pointer to an array containing at least columnCount elements, which will be populated with 0s
+//                       and 1s (no null terminator is added).
+void alifilter_computeBootstrapMask(const alifilter_bootstrap* bootstrap, alifilter_model model, double bootstrapThreshold, int threadCount, double* out_support, char* out_mask);
+
+#ifdef ALIFILTER_BOOTSTRAP_IMPLEMENTATION
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the bootstrap file header.
+#define ALIFILTER_BOOTSTRAP_HEADER_SIZE 48
+
+// Number of columns processed by each work item in alifilter_computeBootstrapMask.
+#define ALIFILTER_BOOTSTRAP_BLOCK_SIZE 256
+
+// Class of characters that are neither gaps nor letters.
+#define ALIFILTER_BOOTSTRAP_OTHER_CLASS (ALIFILTER_BOOTSTRAP_CLASS_COUNT - 1)
+
+int alifilter_parseAccurateSettings(const char* modelFile, double* out_threshold, double* out_bootstrapThreshold, int* out_replicateCount) {
+    // Access the model file.
+    FILE* fileH = fopen(modelFile, "r");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    char buf[255];
+    int found = 0;
+
+    // The settings are stored before the models.
+    while (found != 7 && fscanf(fileH, "%254s", buf) == 1 && strcmp(buf, "\"LogisticModel\":") != 0) {
+        int field = strcmp(buf, "\"AccurateThreshold\":") == 0 ? 1 : strcmp(buf, "\"AccurateBootstrapThreshold\":") == 0 ? 2 : strcmp(buf, "\"AccurateBootstrapReplicates\":") == 0 ? 4 : 0;
+
+        if (field != 0 && fscanf(fileH, " %254[^,} \t\r\n]", buf) == 1) {
+            if (field == 1) {
+                *out_threshold = strtod(buf, NULL);
+            }
+            else if (field == 2) {
+                *out_bootstrapThreshold = strtod(buf, NULL);
+            }
+            else {
+                *out_replicateCount = atoi(buf);
+            }
+
+            found |= field;
+        }
+    }
+
+    fclose(fileH);
+
+    return found == 7 ? 0 : 3;
+}
+
+int alifilter_initBootstrap(alifilter_bootstrap* out_bootstrap, int alignmentLength, int firstColumn, int columnCount, int replicateCount, unsigned long long seed) {
+    if (alignmentLength < 1 || firstColumn < 0 || columnCount < 1 || firstColumn + (long long)columnCount > alignmentLength || replicateCount < 1) {
+        return 2;
+    }
+
+    out_bootstrap->replicateCount = replicateCount;
+    out_bootstrap->seed = seed;
+    out_bootstrap->alignmentLength = alignmentLength;
+    out_bootstrap->firstColumn = firstColumn;
+    out_bootstrap->columnCount = columnCount;
+    out_bootstrap->firstTableColumn = MAX(firstColumn - 2, 0);
+    out_bootstrap->tableColumnCount = MIN(firstColumn + columnCount + 2, alignmentLength) - out_bootstrap->firstTableColumn;
+    out_bootstrap->sequenceCount = 0;
+
+    size_t tableSize = (size_t)(replicateCount + 1) * out_bootstrap->tableColumnCount * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+
+    out_bootstrap->totalWeights = (unsigned long long*)calloc((size_t)replicateCount + 1, sizeof(unsigned long long));
+    out_bootstrap->counts = (unsigned int*)calloc(tableSize, sizeof(unsigned int));
+    out_bootstrap->referenceClasses = (unsigned char*)malloc(out_bootstrap->tableColumnCount * sizeof(unsigned char));
+
+    if (out_bootstrap->totalWeights == NULL || out_bootstrap->counts == NULL || out_bootstrap->referenceClasses == NULL) {
+        alifilter_freeBootstrap(out_bootstrap);
+        return 3;
+    }
+
+    memset(out_bootstrap->referenceClasses, 255, out_bootstrap->tableColumnCount);
+
+    for (int c = 0; c < 256; c++) {
+        if (c == '-') {
+            out_bootstrap->classes[c] = 0;
+        }
+        else if (toupper(c) >= 'A' && toupper(c) <= 'Z') {
+            out_bootstrap->classes[c] = (unsigned char)(1 + toupper(c) - 'A');
+        }
+        else {
+            out_bootstrap->classes[c] = ALIFILTER_BOOTSTRAP_OTHER_CLASS;
+        }
+    }
+
+    return 0;
+}
+
+void alifilter_freeBootstrap(alifilter_bootstrap* bootstrap) {
+    free(bootstrap->totalWeights);
+    free(bootstrap->counts);
+    free(bootstrap->referenceClasses);
+    bootstrap->totalWeights = NULL;
+    bootstrap->counts = NULL;
+    bootstrap->referenceClasses = NULL;
+}
+
+// SplitMix64 finaliser.
+static uint64_t alifilter_bootstrap_mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+unsigned int alifilter_getBootstrapWeight(unsigned long long seed, long long sequenceIndex, int replicate) {
+    uint64_t x = alifilter_bootstrap_mix(seed + 0x9E3779B97F4A7C15ULL * ((uint64_t)sequenceIndex + 1));
+    x = alifilter_bootstrap_mix(x + 0xD1B54A32D192ED03ULL * ((uint64_t)replicate + 1));
+
+    // Uniform number in [0, 1) from the top 53 bits, then inversion of the Poisson(1) distribution function.
+    double u = (double)(x >> 11) * (1.0 / 9007199254740992.0);
+    double p = exp(-1.0);
+    double cdf = p;
+    unsigned int k = 0;
+
+    while (u >= cdf && k < 32) {
+        k++;
+        p /= k;
+        cdf += p;
+    }
+
+    return k;
+}
+
+int alifilter_addBootstrapSequences(alifilter_bootstrap* bootstrap, const char* sequenceData, int sequenceCount, long long firstSequenceIndex) {
+    int replicateCount = bootstrap->replicateCount;
+    int alignmentLength = bootstrap->alignmentLength;
+
+    // Weights of the sequences in each replicate ([sequence][replicate], with replicate 0 being the original alignment).
+    unsigned int* weights = (unsigned int*)malloc((size_t)sequenceCount * (replicateCount + 1) * sizeof(unsigned int));
+    if (weights == NULL) {
+        return 3;
+    }
+
+    for (int s = 0; s < sequenceCount; s++) {
+        unsigned int* sequenceWeights = weights + (size_t)s * (replicateCount + 1);
+        sequenceWeights[0] = 1;
+
+        for (int r = 1; r <= replicateCount; r++) {
+            sequenceWeights[r] = alifilter_getBootstrapWeight(bootstrap->seed, firstSequenceIndex + s, r - 1);
+            bootstrap->totalWeights[r] += sequenceWeights[r];
+        }
+    }
+
+    bootstrap->totalWeights[0] += sequenceCount;
+    bootstrap->sequenceCount += sequenceCount;
+
+    for (int i = 0; i < bootstrap->tableColumnCount; i++) {
+        unsigned int* columnCounts = bootstrap->counts + (size_t)i * (replicateCount + 1) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+        int column = bootstrap->firstTableColumn + i;
+
+        if (bootstrap->referenceClasses[i] == 255 && sequenceCount > 0) {
+            bootstrap->referenceClasses[i] = bootstrap->classes[(unsigned char)sequenceData[column]];
+        }
+
+        for (int s = 0; s < sequenceCount; s++) {
+            unsigned char residueClass = bootstrap->classes[(unsigned char)sequenceData[(size_t)s * alignmentLength + column]];
+
+            // Residues in the reference class are not counted explicitly.
+            if (residueClass == bootstrap->referenceClasses[i]) {
+                continue;
+            }
+
+            const unsigned int* sequenceWeights = weights + (size_t)s * (replicateCount + 1);
+            unsigned int* counts = columnCounts + residueClass;
+
+            for (int r = 0; r <= replicateCount; r++) {
+                counts[r * ALIFILTER_BOOTSTRAP_CLASS_COUNT] += sequenceWeights[r];
+            }
+        }
+    }
+
+    free(weights);
+    return 0;
+}
+
+int alifilter_mergeBootstrap(alifilter_bootstrap* target, const alifilter_bootstrap* source) {
+    if (target->alignmentLength != source->alignmentLength || target->firstColumn != source->firstColumn || target->columnCount != source->columnCount ||
+        target->replicateCount != source->replicateCount || target->seed != source->seed) {
+        return 2;
+    }
+
+    for (int i = 0; i < target->tableColumnCount; i++) {
+        unsigned char targetReference = target->referenceClasses[i];
+        unsigned char sourceReference = source->referenceClasses[i];
+
+        if (targetReference == 255) {
+            target->referenceClasses[i] = targetReference = sourceReference;
+        }
+
+        for (int r = 0; r <= target->replicateCount; r++) {
+            unsigned int* targetCounts = target->counts + ((size_t)i * (target->replicateCount + 1) + r) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+            const unsigned int* sourceCounts = source->counts + ((size_t)i * (source->replicateCount + 1) + r) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+
+            if (sourceReference == targetReference || sourceReference == 255) {
+                for (int c = 0; c < ALIFILTER_BOOTSTRAP_CLASS_COUNT; c++) {
+                    targetCounts[c] += sourceCounts[c];
+                }
+            }
+            else {
+                // The implicit count of the source reference class becomes explicit, and the source count for the
+                // target reference class becomes implicit.
+                unsigned long long sourceExplicit = 0;
+
+                for (int c = 0; c < ALIFILTER_BOOTSTRAP_CLASS_COUNT; c++) {
+                    sourceExplicit += sourceCounts[c];
+
+                    if (c != targetReference) {
+                        targetCounts[c] += sourceCounts[c];
+                    }
+                }
+
+                targetCounts[sourceReference] += (unsigned int)(source->totalWeights[r] - sourceExplicit);
+            }
+        }
+    }
+
+    for (int r = 0; r <= target->replicateCount; r++) {
+        target->totalWeights[r] += source->totalWeights[r];
+    }
+
+    target->sequenceCount += source->sequenceCount;
+
+    return 0;
+}
+
+// Writes an unsigned integer of the specified size in little-endian order.
+static int alifilter_bootstrap_writeUInt(FILE* fileH, uint64_t value, int size) {
+    unsigned char bytes[8];
+
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+    }
+
+    return fwrite(bytes, 1, size, fileH) == (size_t)size;
+}
+
+// Reads an unsigned integer of the specified size in little-endian order.
+static uint64_t alifilter_bootstrap_getUInt(const unsigned char* source, int size) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < size; i++) {
+        value |= (uint64_t)source[i] << (8 * i);
+    }
+
+    return value;
+}
+
+int alifilter_saveBootstrap(const char* bootstrapFile, const alifilter_bootstrap* bootstrap) {
+    FILE* fileH = fopen(bootstrapFile, "wb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    int ok = fwrite("AFBS", 1, 4, fileH) == 4 &&
+        alifilter_bootstrap_writeUInt(fileH, 2, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, bootstrap->seed, 8) &&
+        alifilter_bootstrap_writeUInt(fileH, (uint64_t)bootstrap->sequenceCount, 8) &&
+        alifilter_bootstrap_writeUInt(fileH, (uint32_t)bootstrap->replicateCount, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, (uint32_t)bootstrap->alignmentLength, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, (uint32_t)bootstrap->firstColumn, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, (uint32_t)bootstrap->columnCount, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, ALIFILTER_BOOTSTRAP_CLASS_COUNT, 4) &&
+        alifilter_bootstrap_writeUInt(fileH, 0, 4);
+
+    for (int r = 0; r <= bootstrap->replicateCount && ok; r++) {
+        ok = alifilter_bootstrap_writeUInt(fileH, bootstrap->totalWeights[r], 8);
+    }
+
+    if (ok) {
+        ok = fwrite(bootstrap->referenceClasses, 1, bootstrap->tableColumnCount, fileH) == (size_t)bootstrap->tableColumnCount;
+    }
+
+    // Write the counts in chunks.
+    size_t tableSize = (size_t)(bootstrap->replicateCount + 1) * bootstrap->tableColumnCount * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+    unsigned char buffer[4096];
+
+    for (size_t i = 0; i < tableSize && ok; i += sizeof(buffer) / 4) {
+        size_t chunk = MIN(sizeof(buffer) / 4, tableSize - i);
+
+        for (size_t j = 0; j < chunk; j++) {
+            for (int k = 0; k < 4; k++) {
+                buffer[j * 4 + k] = (unsigned char)((bootstrap->counts[i + j] >> (8 * k)) & 0xFF);
+            }
+        }
+
+        ok = fwrite(buffer, 1, chunk * 4, fileH) == chunk * 4;
+    }
+
+    int result = ok ? 0 : 4;
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+int alifilter_loadBootstrap(const char* bootstrapFile, alifilter_bootstrap* out_bootstrap) {
+    FILE* fileH = fopen(bootstrapFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char header[ALIFILTER_BOOTSTRAP_HEADER_SIZE];
+    int result = 0;
+
+    if (fread(header, 1, ALIFILTER_BOOTSTRAP_HEADER_SIZE, fileH) != ALIFILTER_BOOTSTRAP_HEADER_SIZE) {
+        result = ferror(fileH) ? 4 : 2;
+    }
+    else if (memcmp(header, "AFBS", 4) != 0 || alifilter_bootstrap_getUInt(header + 4, 4) != 2 || alifilter_bootstrap_getUInt(header + 40, 4) != ALIFILTER_BOOTSTRAP_CLASS_COUNT ||
+        alifilter_bootstrap_getUInt(header + 24, 4) > 0x7FFFFFFF || alifilter_bootstrap_getUInt(header + 28, 4) > 0x7FFFFFFF ||
+        alifilter_bootstrap_getUInt(header + 32, 4) > 0x7FFFFFFF || alifilter_bootstrap_getUInt(header + 36, 4) > 0x7FFFFFFF) {
+        result = 2;
+    }
+    else {
+        result = alifilter_initBootstrap(out_bootstrap, (int)alifilter_bootstrap_getUInt(header + 28, 4), (int)alifilter_bootstrap_getUInt(header + 32, 4),
+                                         (int)alifilter_bootstrap_getUInt(header + 36, 4), (int)alifilter_bootstrap_getUInt(header + 24, 4), alifilter_bootstrap_getUInt(header + 8, 8));
+    }
+
+    if (result == 0) {
+        out_bootstrap->sequenceCount = (long long)alifilter_bootstrap_getUInt(header + 16, 8);
+
+        unsigned char buffer[4096];
+
+        for (int r = 0; r <= out_bootstrap->replicateCount && result == 0; r++) {
+            if (fread(buffer, 1, 8, fileH) != 8) {
+                result = ferror(fileH) ? 4 : 2;
+            }
+            else {
+                out_bootstrap->totalWeights[r] = alifilter_bootstrap_getUInt(buffer, 8);
+            }
+        }
+
+        if (result == 0 && fread(out_bootstrap->referenceClasses, 1, out_bootstrap->tableColumnCount, fileH) != (size_t)out_bootstrap->tableColumnCount) {
+            result = ferror(fileH) ? 4 : 2;
+        }
+
+        size_t tableSize = (size_t)(out_bootstrap->replicateCount + 1) * out_bootstrap->tableColumnCount * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+
+        for (size_t i = 0; i < tableSize && result == 0; i += sizeof(buffer) / 4) {
+            size_t chunk = MIN(sizeof(buffer) / 4, tableSize - i);
+
+            if (fread(buffer, 1, chunk * 4, fileH) != chunk * 4) {
+                result = ferror(fileH) ? 4 : 2;
+            }
+            else {
+                for (size_t j = 0; j < chunk; j++) {
+                    out_bootstrap->counts[i + j] = (unsigned int)alifilter_bootstrap_getUInt(buffer + j * 4, 4);
+                }
+            }
+        }
+
+        if (result != 0) {
+            alifilter_freeBootstrap(out_bootstrap);
+        }
+    }
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+// Gets the counts of all the classes (including the reference class) for a column (index in the count tables) in a replicate.
+static void alifilter_bootstrap_getCounts(const alifilter_bootstrap* bootstrap, int replicate, int tableColumn, unsigned int* out_counts) {
+    const unsigned int* counts = bootstrap->counts + ((size_t)tableColumn * (bootstrap->replicateCount + 1) + replicate) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+    unsigned long long explicitCount = 0;
+
+    for (int c = 0; c < ALIFILTER_BOOTSTRAP_CLASS_COUNT; c++) {
+        out_counts[c] = counts[c];
+        explicitCount += counts[c];
+    }
+
+    if (bootstrap->referenceClasses[tableColumn] != 255) {
+        out_counts[bootstrap->referenceClasses[tableColumn]] = (unsigned int)(bootstrap->totalWeights[replicate] - explicitCount);
+    }
+}
+
+// Computes the gap proportion for a column (index in the count tables) in a replicate.
+static double alifilter_bootstrap_getGapProportion(const alifilter_bootstrap* bootstrap, int replicate, int tableColumn) {
+    double totalWeight = (double)bootstrap->totalWeights[replicate];
+
+    if (totalWeight <= 0) {
+        return 0;
+    }
+
+    const unsigned int* counts = bootstrap->counts + ((size_t)tableColumn * (bootstrap->replicateCount + 1) + replicate) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+
+    if (bootstrap->referenceClasses[tableColumn] != 0) {
+        return counts[0] / totalWeight;
+    }
+    else {
+        unsigned long long explicitCount = 0;
+
+        for (int c = 0; c < ALIFILTER_BOOTSTRAP_CLASS_COUNT; c++) {
+            explicitCount += counts[c];
+        }
+
+        return (bootstrap->totalWeights[replicate] - explicitCount) / totalWeight;
+    }
+}
+
+// Returns 1 if all the residues in a column (index in the count tables) belong to the same class, in which case the
+// column has the same features in every replicate with a non-zero total weight.
+static int alifilter_bootstrap_isInvariant(const alifilter_bootstrap* bootstrap, int tableColumn) {
+    const unsigned int* counts = bootstrap->counts + (size_t)tableColumn * (bootstrap->replicateCount + 1) * ALIFILTER_BOOTSTRAP_CLASS_COUNT;
+
+    for (int c = 0; c < ALIFILTER_BOOTSTRAP_CLASS_COUNT; c++) {
+        if (counts[c] != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Computes the windowed gap features for a column in a replicate (the same computations as
+// alifilter_computeAlignmentFeatures), given the gap proportion of the column in out_features[0].
+static void alifilter_bootstrap_computeWindowFeatures(const alifilter_bootstrap* bootstrap, int replicate, int column, double* out_features) {
+    int alignmentLength = bootstrap->alignmentLength;
+    int tableColumn = column - bootstrap->firstTableColumn;
+    int i = column;
+
+    double gap = out_features[0];
+    double gapM1 = i > 0 ? alifilter_bootstrap_getGapProportion(bootstrap, replicate, tableColumn - 1) : 0;
+    double gapM2 = i > 1 ? alifilter_bootstrap_getGapProportion(bootstrap, replicate, tableColumn - 2) : 0;
+    double gapP1 = i < alignmentLength - 1 ? alifilter_bootstrap_getGapProportion(bootstrap, replicate, tableColumn + 1) : 0;
+    double gapP2 = i < alignmentLength - 2 ? alifilter_bootstrap_getGapProportion(bootstrap, replicate, tableColumn + 2) : 0;
+
+    out_features[4] = (gapM1 + gap + gapP1) / (1 + (i > 0 ? 1 : 0) + (i < alignmentLength - 1 ? 1 : 0));
+    out_features[5] = (gapM2 + gapM1 + gap + gapP1 + gapP2) / (1 + (i > 1 ? 2 : i > 0 ? 1 : 0) + (i < alignmentLength - 2 ? 2 : i < alignmentLength - 1 ? 1 : 0));
+}
+
+// Computes the features for a column (the same computations as alifilter_computeColumnFeatures and
+// alifilter_computeAlignmentFeatures, using the counts from the table).
+static void alifilter_bootstrap_computeColumnFeatures(const alifilter_bootstrap* bootstrap, int replicate, int column, double* out_features) {
+    int alignmentLength = bootstrap->alignmentLength;
+    int tableColumn = column - bootstrap->firstTableColumn;
+    double totalWeight = (double)bootstrap->totalWeights[replicate];
+
+    unsigned int counts[ALIFILTER_BOOTSTRAP_CLASS_COUNT];
+    alifilter_bootstrap_getCounts(bootstrap, replicate, tableColumn, counts);
+
+    unsigned long long validChars = 0;
+    for (int c = 1; c <= 'Z' - 'A' + 1; c++) {
+        validChars += counts[c];
+    }
+
+    // % Gaps
+    out_features[0] = totalWeight > 0 ? counts[0] / totalWeight : 0;
+
+    // % Identity and entropy
+    if (validChars > 0) {
+        unsigned int maxId = 0;
+        double entropy = 0;
+
+        for (int c = 1; c <= 'Z' - 'A' + 1; c++) {
+            maxId = MAX(maxId, counts[c]);
+
+            if (counts[c] > 0) {
+                entropy += - (double)counts[c] / validChars * log((double)counts[c] / validChars);
+            }
+        }
+
+        out_features[1] = (double)maxId / totalWeight;
+        out_features[3] = entropy;
+    }
+    else {
+        out_features[1] = 0;
+        out_features[3] = 0;
+    }
+
+    // Distance from extremity
+    out_features[2] = MIN(column, alignmentLength - 1 - column);
+
+    // % Gaps +- 1 and +- 2
+    alifilter_bootstrap_computeWindowFeatures(bootstrap, replicate, column, out_features);
+}
+
+void alifilter_computeBootstrapFeatures(const alifilter_bootstrap* bootstrap, int replicate, double* out_features) {
+    for (int i = 0; i < bootstrap->columnCount; i++) {
+        alifilter_bootstrap_computeColumnFeatures(bootstrap, replicate, bootstrap->firstColumn + i, &out_features[i * ALIFILTER_FEATURE_COUNT]);
+    }
+}
+
+// State shared by the threads computing a bootstrap mask.
+typedef struct {
+    const alifilter_bootstrap* bootstrap;
+    alifilter_model model;
+    double bootstrapThreshold;
+    double* support;
+    char* mask;
+} alifilter_bootstrapMaskState;
+
+// Computes the score for a column from its features, and returns 1 if the column is preserved.
+static int alifilter_bootstrap_isPreserved(alifilter_model model, const double* features) {
+    double score;
+    char columnMask;
+
+    alifilter_computeScores(model, features, 1, &score);
+    alifilter_computeMaskFromScores(model, &score, 1, &columnMask);
+
+    return columnMask == '1';
+}
+
+// Computes the bootstrap mask for a block of columns.
+static void alifilter_bootstrap_computeMaskBlock(int block, void* state) {
+    alifilter_bootstrapMaskState* maskState = (alifilter_bootstrapMaskState*)state;
+    const alifilter_bootstrap* bootstrap = maskState->bootstrap;
+
+    int start = block * ALIFILTER_BOOTSTRAP_BLOCK_SIZE;
+    int end = MIN(start + ALIFILTER_BOOTSTRAP_BLOCK_SIZE, bootstrap->columnCount);
+
+    for (int i = start; i < end; i++) {
+        int column = bootstrap->firstColumn + i;
+        int tableColumn = column - bootstrap->firstTableColumn;
+        int preserved = 0;
+
+        if (alifilter_bootstrap_isInvariant(bootstrap, tableColumn)) {
+            // Features 0-3 are the same in all the replicates (with a non-zero total weight).
+            double invariantFeatures[ALIFILTER_FEATURE_COUNT];
+            alifilter_bootstrap_computeColumnFeatures(bootstrap, 0, column, invariantFeatures);
+
+            // If the neighbouring columns are also invariant, the windowed gap features are the same as well.
+            int windowInvariant = 1;
+            for (int j = MAX(tableColumn - 2, 0); j <= MIN(tableColumn + 2, bootstrap->tableColumnCount - 1) && windowInvariant; j++) {
+                windowInvariant = alifilter_bootstrap_isInvariant(bootstrap, j);
+            }
+
+            int invariantPreserved = windowInvariant ? alifilter_bootstrap_isPreserved(maskState->model, invariantFeatures) : 0;
+
+            for (int r = 1; r <= bootstrap->replicateCount; r++) {
+                if (bootstrap->totalWeights[r] == 0) {
+                    double features[ALIFILTER_FEATURE_COUNT];
+                    alifilter_bootstrap_computeColumnFeatures(bootstrap, r, column, features);
+                    preserved += alifilter_bootstrap_isPreserved(maskState->model, features);
+                }
+                else if (windowInvariant) {
+                    preserved += invariantPreserved;
+                }
+                else {
+                    double features[ALIFILTER_FEATURE_COUNT];
+                    memcpy(features, invariantFeatures, sizeof(features));
+                    alifilter_bootstrap_computeWindowFeatures(bootstrap, r, column, features);
+                    preserved += alifilter_bootstrap_isPreserved(maskState->model, features);
+                }
+            }
+        }
+        else {
+            for (int r = 1; r <= bootstrap->replicateCount; r++) {
+                double features[ALIFILTER_FEATURE_COUNT];
+                alifilter_bootstrap_computeColumnFeatures(bootstrap, r, column, features);
+                preserved += alifilter_bootstrap_isPreserved(maskState->model, features);
+            }
+        }
+
+        double support = (double)preserved / bootstrap->replicateCount;
+
+        if (maskState->support != NULL) {
+            maskState->support[i] = support;
+        }
+
+        maskState->mask[i] = support > maskState->bootstrapThreshold ? '1' : '0';
+    }
+}
+
+void alifilter_computeBootstrapMask(const alifilter_bootstrap* bootstrap, alifilter_model model, double bootstrapThreshold, int threadCount, double* out_support, char* out_mask) {
+    alifilter_bootstrapMaskState state;
+    state.bootstrap = bootstrap;
+    state.model = model;
+    state.bootstrapThreshold = bootstrapThreshold;
+    state.support = out_support;
+    state.mask = out_mask;
+
+    int blockCount = (bootstrap->columnCount + ALIFILTER_BOOTSTRAP_BLOCK_SIZE - 1) / ALIFILTER_BOOTSTRAP_BLOCK_SIZE;
+
+    alifilter_parallelFor(blockCount, threadCount, alifilter_bootstrap_computeMaskBlock, &state);
+}
+
+#endif
+#endif
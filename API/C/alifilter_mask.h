@@ -0,0 +1,643 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_MASK_H
+#define ALIFILTER_MASK_H
+
+// Reading and writing alignment masks in the formats used by the AliFilter command-line program (see the MaskType enum
+// in the C# library), plus a compact binary format for the column scores. The text formats store the "preservation
+// score" of each column (i.e., the score from alifilter_computeScores, or the bootstrap support for preserving the
+// column), so a mask can be re-cut at a different threshold using alifilter_thresholdScores without recomputing the
+// alignment features.
+
+// A sequence of 0s and 1s (one character for each column).
+#define ALIFILTER_MASK_BINARY 0
+
+// One character for each column, using the Sanger convention: a score of p is stored as the ASCII character
+// round(max(126 + 10 * log10(p), 33)). This loses precision, especially for scores close to 0.
+#define ALIFILTER_MASK_FUZZY 1
+
+// Scores separated by spaces, using the shortest representation that reads back to the same value.
+#define ALIFILTER_MASK_FLOAT 2
+
+// Compact binary format: the 4 bytes "AFSC", the number of columns as a little-endian 32-bit integer, and then the
+// score for each column as a little-endian IEEE 754 double. This is lossless.
+#define ALIFILTER_MASK_SCORES 3
+
+// Computes a binary mask from the column scores using a new threshold.
+//   Parameters:
+//     • const double* scores: the score for each column.
+//     • int alignmentLength: the number of columns.
+//     • double threshold: columns with a score greater than or equal to this will be preserved.
+//     • char* out_mask: a pointer to an array containing at least alignmentLength elements, which will be populated with
+//                       0s and 1s (no null terminator is added).
+//
+//   Return value: the number of preserved columns.
+int alifilter_thresholdScores(const double* scores, int alignmentLength, double threshold, char* out_mask);
+
+// Encodes column scores as a fuzzy mask.
+//   Parameters:
+//     • const double* scores: the score for each column (scores greater than 1 are treated as 1).
+//     • int alignmentLength: the number of columns.
+//     • char* out_mask: a pointer to an array containing at least alignmentLength elements, which will be populated with
+//                       the fuzzy mask characters (no null terminator is added).
+void alifilter_encodeFuzzyMask(const double* scores, int alignmentLength, char* out_mask);
+
+// Decodes a fuzzy mask into column scores.
+//   Parameters:
+//     • const char* mask: the fuzzy mask characters.
+//     • int alignmentLength: the number of columns.
+//     • double* out_scores: a pointer to an array containing at least alignmentLength elements, which will be populated with
+//                           the column scores.
+//
+//   Return value: 0 on success, or 1 if the mask contains characters outside of the range ! (33) to ~ (126).
+int alifilter_decodeFuzzyMask(const char* mask, int alignmentLength, double* out_scores);
+
+// Formats a score in the same way as the C# library (i.e., the shortest representation that round-trips, using the
+// invariant culture and exponential notation for values smaller than 0.0001), independently of the current locale.
+//   Parameters:
+//     • double score: the score to format.
+//     • char* out_buffer: a buffer containing at least 32 elements, which will be populated with a null-terminated string.
+//
+//   Return value: the number of characters written (excluding the null terminator).
+int alifilter_formatScore(double score, char* out_buffer);
+
+// Saves a mask to a file in one of the supported formats.
+//   Parameters:
+//     • const char* maskFile: the path to the output file.
+//     • int maskType: ALIFILTER_MASK_BINARY, ALIFILTER_MASK_FUZZY, ALIFILTER_MASK_FLOAT or ALIFILTER_MASK_SCORES.
+//     • const char* mask: the mask (0s and 1s); this is only used if maskType is ALIFILTER_MASK_BINARY, and can be NULL otherwise.
+//     • const double* scores: the column scores; this is only used if maskType is not ALIFILTER_MASK_BINARY, and can be NULL otherwise.
+//     • int alignmentLength: the number of columns.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: invalid mask type
+//     • 3: could not allocate enough memory
+//     • 4: error while writing the file
+//     • 5: error while closing the file
+int alifilter_saveMask(const char* maskFile, int maskType, const char* mask, const double* scores, int alignmentLength);
+
+// Reads the column scores from a mask file.
+//   Parameters:
+//     • const char* maskFile: the path to the mask file.
+//     • int maskType: the format of the file. For ALIFILTER_MASK_BINARY files, the scores are 1 for preserved columns
+//                     and 0 for deleted columns.
+//     • double** out_scores: if the return value is 0 or 5, when this function returns this will point to an array
+//                            containing the score for each column. You should free() this pointer eventually.
+//     • int* out_alignmentLength: if the return value is 0 or 5, when this function returns this will contain the
+//                                 number of columns.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the file is not in the specified format, or the mask type is invalid
+//     • 3: could not allocate enough memory
+//     • 4: error while reading the file
+//     • 5: error while closing the file (but the scores have been read successfully and should be freed)
+int alifilter_loadMaskScores(const char* maskFile, int maskType, double** out_scores, int* out_alignmentLength);
+
+// Reads a mask file and computes a binary mask using a new threshold.
+//   Parameters:
+//     • const char* maskFile: the path to the mask file.
+//     • int maskType: the format of the file.
+//     • double threshold: columns with a score greater than or equal to this will be preserved.
+//     • char** out_mask: if the return value is 0 or 5, when this function returns this will point to a C string
+//                        containing 0s and 1s. You should free() this pointer eventually.
+//
+//   Return value: see alifilter_loadMaskScores.
+int alifilter_rethresholdMask(const char* maskFile, int maskType, double threshold, char** out_mask);
+
+#ifdef ALIFILTER_MASK_IMPLEMENTATION
+
+#include <ctype.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of distinct characters in a fuzzy mask (! to ~).
+#define ALIFILTER_FUZZY_LEVELS 94
+
+int alifilter_thresholdScores(const double* scores, int alignmentLength, double threshold, char* out_mask) {
+    int preserved = 0;
+
+    for (int i = 0; i < alignmentLength; i++) {
+        int keep = scores[i] >= threshold;
+        out_mask[i] = keep ? '1' : '0';
+        preserved += keep;
+    }
+
+    return preserved;
+}
+
+// The fuzzy character for a score, computed in the same way as the C# library (Math.Round rounds to even, like rint).
+static int alifilter_getFuzzyLevel(double score) {
+    return (int)rint(fmax(126 + 10 * log10(score), 33));
+}
+
+// Computes the smallest score that is encoded as each fuzzy character (out_thresholds[k] for character 33 + k, k > 0).
+// Encoding a column then only requires a binary search in this table, rather than a logarithm.
+static void alifilter_getFuzzyThresholds(double* out_thresholds) {
+    out_thresholds[0] = -INFINITY;
+
+    for (int k = 1; k < ALIFILTER_FUZZY_LEVELS; k++) {
+        int level = 33 + k;
+        double threshold = pow(10, (level - 126.5) / 10);
+
+        // Adjust the approximate threshold so that it exactly matches the rounding in alifilter_getFuzzyLevel.
+        while (threshold > 0 && alifilter_getFuzzyLevel(threshold) >= level) {
+            threshold = nextafter(threshold, 0);
+        }
+
+        while (alifilter_getFuzzyLevel(threshold) < level) {
+            threshold = nextafter(threshold, INFINITY);
+        }
+
+        out_thresholds[k] = threshold;
+    }
+}
+
+void alifilter_encodeFuzzyMask(const double* scores, int alignmentLength, char* out_mask) {
+    double thresholds[ALIFILTER_FUZZY_LEVELS];
+    alifilter_getFuzzyThresholds(thresholds);
+
+    for (int i = 0; i < alignmentLength; i++) {
+        // Find the last threshold that is <= the score (NaNs end up at the lowest level).
+        int level = 0;
+
+        for (int step = 64; step > 0; step >>= 1) {
+            if (level + step < ALIFILTER_FUZZY_LEVELS && thresholds[level + step] <= scores[i]) {
+                level += step;
+            }
+        }
+
+        out_mask[i] = (char)(33 + level);
+    }
+}
+
+int alifilter_decodeFuzzyMask(const char* mask, int alignmentLength, double* out_scores) {
+    double levels[ALIFILTER_FUZZY_LEVELS];
+
+    for (int k = 0; k < ALIFILTER_FUZZY_LEVELS; k++) {
+        levels[k] = pow(10, (k + 33 - 126) / 10.0);
+    }
+
+    for (int i = 0; i < alignmentLength; i++) {
+        int level = (unsigned char)mask[i] - 33;
+
+        if (level < 0 || level >= ALIFILTER_FUZZY_LEVELS) {
+            return 1;
+        }
+
+        out_scores[i] = levels[level];
+    }
+
+    return 0;
+}
+
+int alifilter_formatScore(double score, char* out_buffer) {
+    if (isnan(score)) {
+        strcpy(out_buffer, "NaN");
+        return 3;
+    }
+    else if (isinf(score)) {
+        strcpy(out_buffer, score > 0 ? "Infinity" : "-Infinity");
+        return score > 0 ? 8 : 9;
+    }
+    else if (score == 0) {
+        strcpy(out_buffer, signbit(score) ? "-0" : "0");
+        return signbit(score) ? 2 : 1;
+    }
+
+    // Find the shortest number of significant digits that round-trips. If the shortest representation has at most 15
+    // digits, %.14e produces it (followed by zeros).
+    char formatted[40];
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(formatted, sizeof(formatted), "%.*e", precision - 1, score);
+
+        if (precision == 17 || strtod(formatted, NULL) == score) {
+            break;
+        }
+    }
+
+    // Extract the digits and the exponent (ignoring the locale-specific decimal point).
+    char digits[20];
+    int digitCount = 0;
+    int exponent = 0;
+    int negative = 0;
+
+    for (char* c = formatted; *c != 0; c++) {
+        if (*c == '-' && digitCount == 0) {
+            negative = 1;
+        }
+        else if (*c >= '0' && *c <= '9') {
+            digits[digitCount++] = *c;
+        }
+        else if (*c == 'e' || *c == 'E') {
+            exponent = atoi(c + 1);
+            break;
+        }
+    }
+
+    while (digitCount > 1 && digits[digitCount - 1] == '0') {
+        digitCount--;
+    }
+
+    int length = 0;
+
+    if (negative) {
+        out_buffer[length++] = '-';
+    }
+
+    if (exponent < -4 || exponent >= 15) {
+        // Exponential notation, e.g. 1.5E-07.
+        out_buffer[length++] = digits[0];
+
+        if (digitCount > 1) {
+            out_buffer[length++] = '.';
+            memcpy(out_buffer + length, digits + 1, digitCount - 1);
+            length += digitCount - 1;
+        }
+
+        length += sprintf(out_buffer + length, "E%c%02d", exponent < 0 ? '-' : '+', exponent < 0 ? -exponent : exponent);
+    }
+    else if (exponent < 0) {
+        // 0.000ddd
+        out_buffer[length++] = '0';
+        out_buffer[length++] = '.';
+
+        for (int i = -1; i > exponent; i--) {
+            out_buffer[length++] = '0';
+        }
+
+        memcpy(out_buffer + length, digits, digitCount);
+        length += digitCount;
+    }
+    else {
+        // ddd.ddd or ddd000
+        for (int i = 0; i <= exponent || i < digitCount; i++) {
+            if (i == exponent + 1) {
+                out_buffer[length++] = '.';
+            }
+
+            out_buffer[length++] = i < digitCount ? digits[i] : '0';
+        }
+    }
+
+    out_buffer[length] = 0;
+    return length;
+}
+
+// Returns 1 if this machine is little-endian.
+static int alifilter_isLittleEndian(void) {
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// Writes a 32-bit integer in little-endian order.
+static int alifilter_writeInt32(FILE* fileH, int32_t value) {
+    unsigned char bytes[4];
+
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)(((uint32_t)value >> (8 * i)) & 0xFF);
+    }
+
+    return fwrite(bytes, 1, 4, fileH) == 4 ? 0 : 4;
+}
+
+// Writes an array of doubles in little-endian order.
+static int alifilter_writeDoubles(FILE* fileH, const double* values, int count) {
+    if (alifilter_isLittleEndian()) {
+        return fwrite(values, sizeof(double), count, fileH) == (size_t)count ? 0 : 4;
+    }
+
+    for (int i = 0; i < count; i++) {
+        unsigned char bytes[sizeof(double)];
+        unsigned char swapped[sizeof(double)];
+        memcpy(bytes, &values[i], sizeof(double));
+
+        for (size_t j = 0; j < sizeof(double); j++) {
+            swapped[j] = bytes[sizeof(double) - 1 - j];
+        }
+
+        if (fwrite(swapped, 1, sizeof(double), fileH) != sizeof(double)) {
+            return 4;
+        }
+    }
+
+    return 0;
+}
+
+int alifilter_saveMask(const char* maskFile, int maskType, const char* mask, const double* scores, int alignmentLength) {
+    if (maskType < ALIFILTER_MASK_BINARY || maskType > ALIFILTER_MASK_SCORES || (maskType == ALIFILTER_MASK_BINARY ? mask == NULL : scores == NULL)) {
+        return 2;
+    }
+
+    FILE* fileH = fopen(maskFile, maskType == ALIFILTER_MASK_SCORES ? "wb" : "w");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    int result = 0;
+
+    if (maskType == ALIFILTER_MASK_BINARY) {
+        if (fwrite(mask, 1, alignmentLength, fileH) != (size_t)alignmentLength || fputc('\n', fileH) == EOF) {
+            result = 4;
+        }
+    }
+    else if (maskType == ALIFILTER_MASK_FUZZY) {
+        char* fuzzyMask = (char*)malloc((size_t)alignmentLength + 1);
+
+        if (fuzzyMask == NULL) {
+            result = 3;
+        }
+        else {
+            alifilter_encodeFuzzyMask(scores, alignmentLength, fuzzyMask);
+            fuzzyMask[alignmentLength] = '\n';
+
+            if (fwrite(fuzzyMask, 1, (size_t)alignmentLength + 1, fileH) != (size_t)alignmentLength + 1) {
+                result = 4;
+            }
+
+            free(fuzzyMask);
+        }
+    }
+    else if (maskType == ALIFILTER_MASK_FLOAT) {
+        // Format the scores in chunks, to avoid calling fwrite for each column.
+        char buffer[4096];
+        size_t bufferLength = 0;
+
+        for (int i = 0; i < alignmentLength && result == 0; i++) {
+            bufferLength += alifilter_formatScore(scores[i], buffer + bufferLength);
+            buffer[bufferLength++] = i < alignmentLength - 1 ? ' ' : '\n';
+
+            if (bufferLength > sizeof(buffer) - 40 || i == alignmentLength - 1) {
+                if (fwrite(buffer, 1, bufferLength, fileH) != bufferLength) {
+                    result = 4;
+                }
+
+                bufferLength = 0;
+            }
+        }
+
+        if (alignmentLength == 0 && fputc('\n', fileH) == EOF) {
+            result = 4;
+        }
+    }
+    else {
+        if (fwrite("AFSC", 1, 4, fileH) != 4) {
+            result = 4;
+        }
+        else {
+            result = alifilter_writeInt32(fileH, alignmentLength);
+        }
+
+        if (result == 0) {
+            result = alifilter_writeDoubles(fileH, scores, alignmentLength);
+        }
+    }
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+// Reads a whole file in memory (adding a null terminator).
+//   Return value: 0, 1, 3 or 4 (see alifilter_loadMaskScores).
+static int alifilter_readWholeFile(FILE* fileH, char** out_data, size_t* out_size) {
+    char* data = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    while (1) {
+        if (size + 1 >= capacity) {
+            capacity = capacity == 0 ? 1 << 16 : capacity * 2;
+            char* newData = (char*)realloc(data, capacity);
+
+            if (newData == NULL) {
+                free(data);
+                return 3;
+            }
+
+            data = newData;
+        }
+
+        size_t readChars = fread(data + size, 1, capacity - size - 1, fileH);
+
+        if (readChars == 0) {
+            break;
+        }
+
+        size += readChars;
+    }
+
+    if (ferror(fileH)) {
+        free(data);
+        return 4;
+    }
+
+    data[size] = 0;
+    *out_data = data;
+    *out_size = size;
+    return 0;
+}
+
+// Parses the scores from the contents of a mask file.
+//   Return value: 0, 2 or 3 (see alifilter_loadMaskScores).
+static int alifilter_parseMaskScores(char* data, size_t size, int maskType, double** out_scores, int* out_alignmentLength) {
+    if (maskType == ALIFILTER_MASK_SCORES) {
+        if (size < 8 || memcmp(data, "AFSC", 4) != 0) {
+            return 2;
+        }
+
+        uint32_t length = 0;
+        for (int i = 0; i < 4; i++) {
+            length |= (uint32_t)(unsigned char)data[4 + i] << (8 * i);
+        }
+
+        if (length > 0x7FFFFFFF || size != 8 + (size_t)length * sizeof(double)) {
+            return 2;
+        }
+
+        double* scores = (double*)malloc(((size_t)length + 1) * sizeof(double));
+        if (scores == NULL) {
+            return 3;
+        }
+
+        memcpy(scores, data + 8, (size_t)length * sizeof(double));
+
+        if (!alifilter_isLittleEndian()) {
+            for (uint32_t i = 0; i < length; i++) {
+                unsigned char bytes[sizeof(double)];
+                memcpy(bytes, data + 8 + (size_t)i * sizeof(double), sizeof(double));
+
+                for (size_t j = 0; j < sizeof(double) / 2; j++) {
+                    unsigned char tmp = bytes[j];
+                    bytes[j] = bytes[sizeof(double) - 1 - j];
+                    bytes[sizeof(double) - 1 - j] = tmp;
+                }
+
+                memcpy(&scores[i], bytes, sizeof(double));
+            }
+        }
+
+        *out_scores = scores;
+        *out_alignmentLength = (int)length;
+        return 0;
+    }
+
+    // The length of a text mask is at most the number of characters in the file.
+    if (size > 0x7FFFFFFF) {
+        return 2;
+    }
+
+    double* scores = (double*)malloc((size + 1) * sizeof(double));
+    if (scores == NULL) {
+        return 3;
+    }
+
+    int length = 0;
+
+    if (maskType == ALIFILTER_MASK_FLOAT) {
+        // strtod uses the decimal point of the current locale, while mask files always use a dot.
+        char decimalPoint = localeconv()->decimal_point[0];
+        char* c = data;
+
+        while (1) {
+            while (isspace((unsigned char)*c)) {
+                c++;
+            }
+
+            if (*c == 0) {
+                break;
+            }
+
+            char* tokenEnd = c;
+            while (*tokenEnd != 0 && !isspace((unsigned char)*tokenEnd)) {
+                if (*tokenEnd == '.') {
+                    *tokenEnd = decimalPoint;
+                }
+                tokenEnd++;
+            }
+
+            char* parsedEnd;
+            scores[length] = strtod(c, &parsedEnd);
+
+            if (parsedEnd != tokenEnd) {
+                free(scores);
+                return 2;
+            }
+
+            length++;
+            c = tokenEnd;
+        }
+    }
+    else {
+        // Whitespace is ignored, as in the C# library.
+        char* compacted = data;
+
+        for (size_t i = 0; i < size; i++) {
+            if (!isspace((unsigned char)data[i])) {
+                compacted[length++] = data[i];
+            }
+        }
+
+        if (maskType == ALIFILTER_MASK_FUZZY) {
+            if (alifilter_decodeFuzzyMask(compacted, length, scores) != 0) {
+                free(scores);
+                return 2;
+            }
+        }
+        else {
+            for (int i = 0; i < length; i++) {
+                if (compacted[i] != '0' && compacted[i] != '1') {
+                    free(scores);
+                    return 2;
+                }
+
+                scores[i] = compacted[i] == '1' ? 1 : 0;
+            }
+        }
+    }
+
+    *out_scores = scores;
+    *out_alignmentLength = length;
+    return 0;
+}
+
+int alifilter_loadMaskScores(const char* maskFile, int maskType, double** out_scores, int* out_alignmentLength) {
+    if (maskType < ALIFILTER_MASK_BINARY || maskType > ALIFILTER_MASK_SCORES) {
+        return 2;
+    }
+
+    FILE* fileH = fopen(maskFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    char* data;
+    size_t size;
+    int result = alifilter_readWholeFile(fileH, &data, &size);
+
+    if (result == 0) {
+        result = alifilter_parseMaskScores(data, size, maskType, out_scores, out_alignmentLength);
+        free(data);
+    }
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+int alifilter_rethresholdMask(const char* maskFile, int maskType, double threshold, char** out_mask) {
+    double* scores;
+    int alignmentLength;
+    int result = alifilter_loadMaskScores(maskFile, maskType, &scores, &alignmentLength);
+
+    if (result != 0 && result != 5) {
+        return result;
+    }
+
+    char* mask = (char*)malloc((size_t)alignmentLength + 1);
+
+    if (mask == NULL) {
+        free(scores);
+        return 3;
+    }
+
+    alifilter_thresholdScores(scores, alignmentLength, threshold, mask);
+    mask[alignmentLength] = 0;
+
+    free(scores);
+    *out_mask = mask;
+    return result;
+}
+
+#endif
+#endif
@@ -0,0 +1,305 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_PROFILE_H
+#define ALIFILTER_PROFILE_H
+
+// Incremental re-filtering of an alignment that is being edited. A profile stores the features, scores and mask of every
+// column; when a range of columns is replaced (e.g., because a region has been re-aligned, or columns have been inserted
+// or deleted), only the features of the new columns are computed from the sequences. The windowed gap features are
+// updated for the two columns on either side of the edit, and the distance from the extremity (and thus the score) is
+// updated for the columns whose distance has changed (if the alignment length changes); these updates only use the
+// stored features, so the work that depends on the number of sequences is proportional to the size of the edit.
+//
+// The profile does not keep a copy of the sequences: the caller is responsible for applying the same edit to its own
+// copy of the alignment. This requires the implementation from alifilter.h.
+
+#include "alifilter.h"
+
+// Represents the features, scores and mask of an alignment.
+typedef struct {
+    // The model used to compute the scores and the mask.
+    alifilter_model model;
+
+    // Number of sequences in the alignment.
+    int sequenceCount;
+
+    // Current length of the alignment.
+    int alignmentLength;
+
+    // Number of columns for which memory has been allocated.
+    int capacity;
+
+    // Features for each column (alignmentLength * ALIFILTER_FEATURE_COUNT elements).
+    double* features;
+
+    // Score for each column (alignmentLength elements).
+    double* scores;
+
+    // The mask (a null-terminated string containing alignmentLength 0s and 1s).
+    char* mask;
+} alifilter_profile;
+
+// Creates a profile for an alignment.
+//   Parameters:
+//     • alifilter_model model: the model to use.
+//     • const char* sequenceData: the alignment sequence data (it should contain sequenceCount * alignmentLength elements).
+//     • int sequenceCount: the number of sequences in the alignment.
+//     • int alignmentLength: the length of each sequence in the alignment.
+//     • alifilter_profile* out_profile: if this function returns 0, this will contain the profile (which should be freed
+//                                       using alifilter_freeProfile).
+//
+//   Return value:
+//     • 0: success
+//     • 2: invalid parameters
+//     • 3: could not allocate enough memory
+int alifilter_createProfile(alifilter_model model, const char* sequenceData, int sequenceCount, int alignmentLength, alifilter_profile* out_profile);
+
+// Frees the memory used by a profile.
+void alifilter_freeProfile(alifilter_profile* profile);
+
+// Replaces a range of columns in the profile, updating the features, scores and mask.
+//   Parameters:
+//     • alifilter_profile* profile: the profile.
+//     • int firstColumn: the first column to replace (between 0 and alignmentLength).
+//     • int removedColumnCount: the number of columns that are removed (0 to only insert columns).
+//     • const char* columnData: the new columns (sequenceCount * insertedColumnCount elements, i.e. the new segment of
+//                               the first sequence, followed by the new segment of the second sequence, etc.).
+//     • int insertedColumnCount: the number of columns that are inserted (0 to only remove columns).
+//     • int** out_changedColumns: if this is not NULL and the function returns 0, this will point to an array containing
+//                                 the indices (after the edit) of the inserted columns, followed by the indices of the
+//                                 other columns whose mask value has changed. You should free() this pointer eventually.
+//     • int* out_changedColumnCount: if out_changedColumns is not NULL and the function returns 0, this will contain the
+//                                    number of elements in out_changedColumns.
+//
+//   Return value:
+//     • 0: success (the new mask is in profile->mask)
+//     • 2: invalid parameters (e.g., the edit would remove all the columns)
+//     • 3: could not allocate enough memory (the profile has not been changed)
+int alifilter_replaceProfileColumns(alifilter_profile* profile, int firstColumn, int removedColumnCount, const char* columnData, int insertedColumnCount, int** out_changedColumns, int* out_changedColumnCount);
+
+#ifdef ALIFILTER_PROFILE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+// Ensures that the profile can hold the specified number of columns.
+//   Return value: 0 on success, or 3 if there was not enough memory.
+static int alifilter_profile_reserve(alifilter_profile* profile, int columnCount) {
+    if (columnCount <= profile->capacity) {
+        return 0;
+    }
+
+    long long newCapacity = MAX((long long)columnCount, (long long)profile->capacity * 3 / 2);
+    newCapacity = MIN(newCapacity, 0x7FFFFFFE);
+
+    double* features = (double*)realloc(profile->features, (size_t)newCapacity * ALIFILTER_FEATURE_COUNT * sizeof(double));
+    if (features == NULL) {
+        return 3;
+    }
+    profile->features = features;
+
+    double* scores = (double*)realloc(profile->scores, (size_t)newCapacity * sizeof(double));
+    if (scores == NULL) {
+        return 3;
+    }
+    profile->scores = scores;
+
+    char* mask = (char*)realloc(profile->mask, ((size_t)newCapacity + 1) * sizeof(char));
+    if (mask == NULL) {
+        return 3;
+    }
+    profile->mask = mask;
+
+    profile->capacity = (int)newCapacity;
+    return 0;
+}
+
+int alifilter_createProfile(alifilter_model model, const char* sequenceData, int sequenceCount, int alignmentLength, alifilter_profile* out_profile) {
+    if (sequenceCount < 1 || alignmentLength < 1) {
+        return 2;
+    }
+
+    out_profile->model = model;
+    out_profile->sequenceCount = sequenceCount;
+    out_profile->alignmentLength = alignmentLength;
+    out_profile->capacity = 0;
+    out_profile->features = NULL;
+    out_profile->scores = NULL;
+    out_profile->mask = NULL;
+
+    if (alifilter_profile_reserve(out_profile, alignmentLength) != 0) {
+        alifilter_freeProfile(out_profile);
+        return 3;
+    }
+
+    alifilter_computeAlignmentFeatures(sequenceData, sequenceCount, alignmentLength, out_profile->features);
+    alifilter_computeScores(model, out_profile->features, alignmentLength, out_profile->scores);
+    alifilter_computeMaskFromScores(model, out_profile->scores, alignmentLength, out_profile->mask);
+    out_profile->mask[alignmentLength] = '\0';
+
+    return 0;
+}
+
+void alifilter_freeProfile(alifilter_profile* profile) {
+    free(profile->features);
+    free(profile->scores);
+    free(profile->mask);
+    profile->features = NULL;
+    profile->scores = NULL;
+    profile->mask = NULL;
+    profile->capacity = 0;
+}
+
+// Distance of a column from the extremity of an alignment with the specified length.
+static int alifilter_profile_getDistance(int column, int alignmentLength) {
+    return MIN(column, alignmentLength - 1 - column);
+}
+
+// Recomputes the windowed gap features of a column from the stored gap proportions (the same computations as
+// alifilter_computeAlignmentFeatures).
+static void alifilter_profile_updateWindowFeatures(alifilter_profile* profile, int i) {
+    double* features = profile->features;
+    int alignmentLength = profile->alignmentLength;
+
+    // % Gaps +- 1
+    features[ALIFILTER_FEATURE_COUNT * i + 4] = ((i > 0 ? features[ALIFILTER_FEATURE_COUNT * (i - 1) + 0] : 0) +
+                                                 features[ALIFILTER_FEATURE_COUNT * i + 0] +
+                                                 (i < alignmentLength - 1 ? features[ALIFILTER_FEATURE_COUNT * (i + 1) + 0] : 0)) /
+                                                 (1 + (i > 0 ? 1 : 0) + (i < alignmentLength - 1 ? 1 : 0));
+
+    // % Gaps +- 2
+    features[ALIFILTER_FEATURE_COUNT * i + 5] = ((i > 1 ? features[ALIFILTER_FEATURE_COUNT * (i - 2) + 0] : 0) +
+                                                 (i > 0 ? features[ALIFILTER_FEATURE_COUNT * (i - 1) + 0] : 0) +
+                                                 features[ALIFILTER_FEATURE_COUNT * i + 0] +
+                                                 (i < alignmentLength - 1 ? features[ALIFILTER_FEATURE_COUNT * (i + 1) + 0] : 0) +
+                                                 (i < alignmentLength - 2 ? features[ALIFILTER_FEATURE_COUNT * (i + 2) + 0] : 0)) /
+                                                 (1 + (i > 1 ? 2 : i > 0 ? 1 : 0) + (i < alignmentLength - 2 ? 2 : i < alignmentLength - 1 ? 1 : 0));
+}
+
+// Recomputes the score and mask of a column, and records it if its mask value has changed.
+static void alifilter_profile_rescore(alifilter_profile* profile, int i, int* changedColumns, int* changedColumnCount) {
+    char previousMask = profile->mask[i];
+
+    alifilter_computeScores(profile->model, &profile->features[ALIFILTER_FEATURE_COUNT * i], 1, &profile->scores[i]);
+    alifilter_computeMaskFromScores(profile->model, &profile->scores[i], 1, &profile->mask[i]);
+
+    if (changedColumns != NULL && profile->mask[i] != previousMask) {
+        changedColumns[(*changedColumnCount)++] = i;
+    }
+}
+
+int alifilter_replaceProfileColumns(alifilter_profile* profile, int firstColumn, int removedColumnCount, const char* columnData, int insertedColumnCount, int** out_changedColumns, int* out_changedColumnCount) {
+    int oldLength = profile->alignmentLength;
+
+    if (firstColumn < 0 || firstColumn > oldLength || removedColumnCount < 0 || removedColumnCount > oldLength - firstColumn || insertedColumnCount < 0 ||
+        (long long)oldLength - removedColumnCount + insertedColumnCount < 1 || (long long)oldLength - removedColumnCount + insertedColumnCount > 0x7FFFFFFE) {
+        return 2;
+    }
+
+    int newLength = oldLength - removedColumnCount + insertedColumnCount;
+    int delta = insertedColumnCount - removedColumnCount;
+
+    // The changed columns are at most all the columns.
+    int* changedColumns = NULL;
+    int changedColumnCount = 0;
+
+    if (out_changedColumns != NULL) {
+        changedColumns = (int*)malloc((size_t)newLength * sizeof(int));
+
+        if (changedColumns == NULL) {
+            return 3;
+        }
+    }
+
+    if (alifilter_profile_reserve(profile, newLength) != 0) {
+        free(changedColumns);
+        return 3;
+    }
+
+    // Move the columns after the edited range.
+    int tailStart = firstColumn + removedColumnCount;
+    int tailLength = oldLength - tailStart;
+
+    if (delta != 0 && tailLength > 0) {
+        memmove(&profile->features[ALIFILTER_FEATURE_COUNT * (tailStart + delta)], &profile->features[ALIFILTER_FEATURE_COUNT * tailStart], (size_t)tailLength * ALIFILTER_FEATURE_COUNT * sizeof(double));
+        memmove(&profile->scores[tailStart + delta], &profile->scores[tailStart], (size_t)tailLength * sizeof(double));
+        memmove(&profile->mask[tailStart + delta], &profile->mask[tailStart], (size_t)tailLength * sizeof(char));
+    }
+
+    profile->alignmentLength = newLength;
+    profile->mask[newLength] = '\0';
+
+    // Compute the features for the new columns (the distance from the extremity that is computed here refers to the
+    // inserted block, so it is overwritten later).
+    for (int i = 0; i < insertedColumnCount; i++) {
+        alifilter_computeColumnFeatures(columnData, profile->sequenceCount, insertedColumnCount, i, &profile->features[ALIFILTER_FEATURE_COUNT * (firstColumn + i)]);
+        profile->mask[firstColumn + i] = 0;
+
+        if (changedColumns != NULL) {
+            changedColumns[changedColumnCount++] = firstColumn + i;
+        }
+    }
+
+    // Columns whose windowed gap features may have changed: the new columns and two columns on either side.
+    int windowStart = MAX(firstColumn - 2, 0);
+    int windowEnd = MIN(firstColumn + insertedColumnCount + 2, newLength);
+
+    for (int i = windowStart; i < windowEnd; i++) {
+        profile->features[ALIFILTER_FEATURE_COUNT * i + 2] = alifilter_profile_getDistance(i, newLength);
+        alifilter_profile_updateWindowFeatures(profile, i);
+        alifilter_profile_rescore(profile, i, i < firstColumn || i >= firstColumn + insertedColumnCount ? changedColumns : NULL, &changedColumnCount);
+    }
+
+    // Columns whose distance from the extremity may have changed. Before the edit, only columns in the second half of
+    // the alignment (measured from the end); after the edit, only columns in the first half (measured from the start).
+    if (delta != 0) {
+        for (int i = MAX(MIN(oldLength, newLength) / 2 - 1, 0); i < windowStart && i < firstColumn; i++) {
+            int distance = alifilter_profile_getDistance(i, newLength);
+
+            if (profile->features[ALIFILTER_FEATURE_COUNT * i + 2] != distance) {
+                profile->features[ALIFILTER_FEATURE_COUNT * i + 2] = distance;
+                alifilter_profile_rescore(profile, i, changedColumns, &changedColumnCount);
+            }
+        }
+
+        long long lastShifted = MIN((long long)MAX(oldLength, newLength) / 2 + (delta > 0 ? delta : -delta) + 1, (long long)newLength - 1);
+
+        for (int i = windowEnd; i <= lastShifted; i++) {
+            int distance = alifilter_profile_getDistance(i, newLength);
+
+            if (profile->features[ALIFILTER_FEATURE_COUNT * i + 2] != distance) {
+                profile->features[ALIFILTER_FEATURE_COUNT * i + 2] = distance;
+                alifilter_profile_rescore(profile, i, changedColumns, &changedColumnCount);
+            }
+        }
+    }
+
+    if (out_changedColumns != NULL) {
+        *out_changedColumns = changedColumns;
+        *out_changedColumnCount = changedColumnCount;
+    }
+
+    return 0;
+}
+
+#endif
+#endif
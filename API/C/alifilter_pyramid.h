@@ -0,0 +1,571 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_PYRAMID_H
+#define ALIFILTER_PYRAMID_H
+
+#include "alifilter.h"
+
+// Multi-resolution summaries of the alignment features, column scores and mask, for plotting long alignments. Level 0
+// contains the value of each track for each column; each subsequent level groups the bins of the previous level in
+// groups of ALIFILTER_PYRAMID_FACTOR and stores the minimum, mean and maximum of each track within each bin. The
+// pyramid is saved as a "sidecar" file that can be memory-mapped, so that any range of columns can be summarised at
+// a resolution appropriate for the display by reading a bounded number of bins.
+//
+// Sidecar file format (all values little-endian):
+//     • 4 bytes: "AFPY"
+//     • uint32: format version (1)
+//     • uint32: number of tracks (ALIFILTER_PYRAMID_TRACK_COUNT)
+//     • uint32: number of levels
+//     • uint64: number of alignment columns
+//     • for each level: uint64 offset of the level data from the start of the file, uint64 number of bins,
+//       uint64 number of columns in each bin (the last bin may contain fewer columns)
+//     • level 0 data: one float for each track for each column
+//     • data for levels > 0: for each bin, for each track, three floats (minimum, mean, maximum)
+
+// The number of tracks in the pyramid: the ALIFILTER_FEATURE_COUNT features, followed by the column score and the
+// preserved fraction (the mean of the mask, where preserved columns count as 1 and deleted columns as 0).
+#define ALIFILTER_PYRAMID_TRACK_COUNT 8
+
+// Index of the column score track.
+#define ALIFILTER_PYRAMID_SCORE_TRACK 6
+
+// Index of the preserved fraction track.
+#define ALIFILTER_PYRAMID_KEEP_TRACK 7
+
+// Number of bins from the previous level that are grouped in each bin.
+#define ALIFILTER_PYRAMID_FACTOR 4
+
+// Represents a memory-mapped pyramid file.
+typedef struct {
+    // Start of the mapped file.
+    const unsigned char* data;
+
+    // Size of the mapped file.
+    unsigned long long size;
+
+    // Number of alignment columns.
+    long long columnCount;
+
+    // Number of levels in the pyramid.
+    int levelCount;
+
+    // Operating system handles (used internally).
+    void* fileHandle;
+    void* mappingHandle;
+} alifilter_pyramid;
+
+// Builds a pyramid and saves it to a file.
+//   Parameters:
+//     • const char* pyramidFile: the path to the output file.
+//     • const double* alignmentFeatures: the alignment features (alignmentLength * ALIFILTER_FEATURE_COUNT elements).
+//     • const double* alignmentScores: the column scores (alignmentLength elements).
+//     • const char* mask: the alignment mask (alignmentLength 0s and 1s).
+//     • int alignmentLength: the number of columns.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 3: could not allocate enough memory
+//     • 4: error while writing the file
+//     • 5: error while closing the file
+int alifilter_savePyramid(const char* pyramidFile, const double* alignmentFeatures, const double* alignmentScores, const char* mask, int alignmentLength);
+
+// Opens a pyramid file by memory-mapping it.
+//   Parameters:
+//     • const char* pyramidFile: the path to the pyramid file.
+//     • alifilter_pyramid* out_pyramid: if the return value is 0, when this function returns this will contain the opened
+//                                       pyramid (which should be closed using alifilter_closePyramid).
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening or mapping the file
+//     • 2: the file is not a valid pyramid file
+int alifilter_openPyramid(const char* pyramidFile, alifilter_pyramid* out_pyramid);
+
+// Closes a pyramid file.
+void alifilter_closePyramid(alifilter_pyramid* pyramid);
+
+// Gets the number of columns summarised by each bin at the specified level (1 for level 0), or -1 if the level is invalid.
+long long alifilter_getPyramidBinSize(const alifilter_pyramid* pyramid, int level);
+
+// Gets the number of bins at the specified level, or -1 if the level is invalid.
+long long alifilter_getPyramidBinCount(const alifilter_pyramid* pyramid, int level);
+
+// Selects the finest level at which the specified range of columns is covered by at most maxBins bins (e.g., the width
+// of the plot in pixels), or the coarsest level if none is fine enough.
+//   Parameters:
+//     • const alifilter_pyramid* pyramid: the pyramid.
+//     • long long firstColumn: the first column in the range.
+//     • long long columnCount: the number of columns in the range.
+//     • int maxBins: the maximum number of bins.
+int alifilter_selectPyramidLevel(const alifilter_pyramid* pyramid, long long firstColumn, long long columnCount, int maxBins);
+
+// Reads a range of bins from a level of the pyramid.
+//   Parameters:
+//     • const alifilter_pyramid* pyramid: the pyramid.
+//     • int level: the level to read.
+//     • long long firstBin: the first bin to read. Bin i at level l covers columns i * binSize to (i + 1) * binSize - 1,
+//                           where binSize is ALIFILTER_PYRAMID_FACTOR^l.
+//     • int binCount: the number of bins to read.
+//     • float* out_stats: a pointer to an array containing at least binCount * ALIFILTER_PYRAMID_TRACK_COUNT * 3 elements,
+//                         which will be populated with the minimum, mean and maximum of each track for each bin (i.e.,
+//                         out_stats[(bin * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3 + 0/1/2]). At level 0, the three
+//                         values are all equal to the column value.
+//
+//   Return value: the number of bins that were read (which may be less than binCount at the end of the alignment), or -1
+//                 if the level or firstBin are invalid.
+int alifilter_queryPyramid(const alifilter_pyramid* pyramid, int level, long long firstBin, int binCount, float* out_stats);
+
+#ifdef ALIFILTER_PYRAMID_IMPLEMENTATION
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Size of the pyramid file header, excluding the level table.
+#define ALIFILTER_PYRAMID_HEADER_SIZE 24
+
+// Returns 1 if this machine is little-endian.
+static int alifilter_pyramid_isLittleEndian(void) {
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// Stores an unsigned integer of the specified size in little-endian order.
+static void alifilter_pyramid_putUInt(unsigned char* target, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        target[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// Reads an unsigned integer of the specified size in little-endian order.
+static uint64_t alifilter_pyramid_getUInt(const unsigned char* source, int size) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < size; i++) {
+        value |= (uint64_t)source[i] << (8 * i);
+    }
+
+    return value;
+}
+
+// Converts an array of floats between the native and little-endian byte order (in place).
+static void alifilter_pyramid_swapFloats(float* values, size_t count) {
+    if (alifilter_pyramid_isLittleEndian()) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        unsigned char bytes[sizeof(float)];
+        memcpy(bytes, &values[i], sizeof(float));
+
+        for (size_t j = 0; j < sizeof(float) / 2; j++) {
+            unsigned char tmp = bytes[j];
+            bytes[j] = bytes[sizeof(float) - 1 - j];
+            bytes[sizeof(float) - 1 - j] = tmp;
+        }
+
+        memcpy(&values[i], bytes, sizeof(float));
+    }
+}
+
+// Gets the value of a track for a column.
+static double alifilter_pyramid_getTrackValue(const double* alignmentFeatures, const double* alignmentScores, const char* mask, int column, int track) {
+    if (track < ALIFILTER_FEATURE_COUNT) {
+        return alignmentFeatures[column * ALIFILTER_FEATURE_COUNT + track];
+    }
+    else if (track == ALIFILTER_PYRAMID_SCORE_TRACK) {
+        return alignmentScores[column];
+    }
+    else {
+        return mask[column] == '1' ? 1 : 0;
+    }
+}
+
+int alifilter_savePyramid(const char* pyramidFile, const double* alignmentFeatures, const double* alignmentScores, const char* mask, int alignmentLength) {
+    // Determine the number of levels.
+    int levelCount = 1;
+    for (long long binCount = alignmentLength; binCount > 1; binCount = (binCount + ALIFILTER_PYRAMID_FACTOR - 1) / ALIFILTER_PYRAMID_FACTOR) {
+        levelCount++;
+    }
+
+    // Statistics for the current level, in double precision (min, sum, max for each track for each bin) and as floats (min, mean, max).
+    size_t level1Bins = ((size_t)alignmentLength + ALIFILTER_PYRAMID_FACTOR - 1) / ALIFILTER_PYRAMID_FACTOR;
+    size_t bufferSize = (level1Bins > 0 ? level1Bins : 1) * ALIFILTER_PYRAMID_TRACK_COUNT * 3;
+    size_t level0Size = ((size_t)alignmentLength > 0 ? (size_t)alignmentLength : 1) * ALIFILTER_PYRAMID_TRACK_COUNT;
+
+    double* stats = (double*)malloc(bufferSize * sizeof(double));
+    float* floatStats = (float*)malloc((bufferSize > level0Size ? bufferSize : level0Size) * sizeof(float));
+
+    if (stats == NULL || floatStats == NULL) {
+        free(stats);
+        free(floatStats);
+        return 3;
+    }
+
+    FILE* fileH = fopen(pyramidFile, "wb");
+    if (fileH == NULL) {
+        free(stats);
+        free(floatStats);
+        return 1;
+    }
+
+    int result = 0;
+
+    // Header and level table.
+    size_t headerSize = ALIFILTER_PYRAMID_HEADER_SIZE + (size_t)levelCount * 24;
+    unsigned char* header = (unsigned char*)calloc(headerSize, 1);
+
+    if (header == NULL) {
+        result = 3;
+    }
+    else {
+        memcpy(header, "AFPY", 4);
+        alifilter_pyramid_putUInt(header + 4, 1, 4);
+        alifilter_pyramid_putUInt(header + 8, ALIFILTER_PYRAMID_TRACK_COUNT, 4);
+        alifilter_pyramid_putUInt(header + 12, levelCount, 4);
+        alifilter_pyramid_putUInt(header + 16, alignmentLength, 8);
+
+        uint64_t offset = headerSize;
+        uint64_t binCount = alignmentLength;
+        uint64_t binSize = 1;
+
+        for (int level = 0; level < levelCount; level++) {
+            unsigned char* entry = header + ALIFILTER_PYRAMID_HEADER_SIZE + level * 24;
+            alifilter_pyramid_putUInt(entry, offset, 8);
+            alifilter_pyramid_putUInt(entry + 8, binCount, 8);
+            alifilter_pyramid_putUInt(entry + 16, binSize, 8);
+
+            offset += binCount * ALIFILTER_PYRAMID_TRACK_COUNT * (level == 0 ? 1 : 3) * sizeof(float);
+            binCount = (binCount + ALIFILTER_PYRAMID_FACTOR - 1) / ALIFILTER_PYRAMID_FACTOR;
+            binSize *= ALIFILTER_PYRAMID_FACTOR;
+        }
+
+        if (fwrite(header, 1, headerSize, fileH) != headerSize) {
+            result = 4;
+        }
+
+        free(header);
+    }
+
+    // Level 0: the value of each track for each column.
+    if (result == 0) {
+        for (int i = 0; i < alignmentLength; i++) {
+            for (int track = 0; track < ALIFILTER_PYRAMID_TRACK_COUNT; track++) {
+                floatStats[i * ALIFILTER_PYRAMID_TRACK_COUNT + track] = (float)alifilter_pyramid_getTrackValue(alignmentFeatures, alignmentScores, mask, i, track);
+            }
+        }
+
+        alifilter_pyramid_swapFloats(floatStats, (size_t)alignmentLength * ALIFILTER_PYRAMID_TRACK_COUNT);
+
+        if (fwrite(floatStats, sizeof(float), (size_t)alignmentLength * ALIFILTER_PYRAMID_TRACK_COUNT, fileH) != (size_t)alignmentLength * ALIFILTER_PYRAMID_TRACK_COUNT) {
+            result = 4;
+        }
+    }
+
+    // Level 1 is computed from the columns, each subsequent level from the previous one (in place, since each bin only
+    // depends on bins with an index that is greater than or equal to its own).
+    long long previousBinCount = alignmentLength;
+    long long binSize = 1;
+
+    for (int level = 1; level < levelCount && result == 0; level++) {
+        long long binCount = (previousBinCount + ALIFILTER_PYRAMID_FACTOR - 1) / ALIFILTER_PYRAMID_FACTOR;
+        binSize *= ALIFILTER_PYRAMID_FACTOR;
+
+        for (long long bin = 0; bin < binCount; bin++) {
+            double* binStats = stats + bin * ALIFILTER_PYRAMID_TRACK_COUNT * 3;
+            double binMin[ALIFILTER_PYRAMID_TRACK_COUNT];
+            double binSum[ALIFILTER_PYRAMID_TRACK_COUNT];
+            double binMax[ALIFILTER_PYRAMID_TRACK_COUNT];
+
+            for (int track = 0; track < ALIFILTER_PYRAMID_TRACK_COUNT; track++) {
+                binMin[track] = INFINITY;
+                binSum[track] = 0;
+                binMax[track] = -INFINITY;
+            }
+
+            long long firstChild = bin * ALIFILTER_PYRAMID_FACTOR;
+            long long lastChild = firstChild + ALIFILTER_PYRAMID_FACTOR < previousBinCount ? firstChild + ALIFILTER_PYRAMID_FACTOR : previousBinCount;
+
+            for (long long child = firstChild; child < lastChild; child++) {
+                for (int track = 0; track < ALIFILTER_PYRAMID_TRACK_COUNT; track++) {
+                    double childMin, childSum, childMax;
+
+                    if (level == 1) {
+                        childMin = childSum = childMax = alifilter_pyramid_getTrackValue(alignmentFeatures, alignmentScores, mask, (int)child, track);
+                    }
+                    else {
+                        const double* childStats = stats + (child * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3;
+                        childMin = childStats[0];
+                        childSum = childStats[1];
+                        childMax = childStats[2];
+                    }
+
+                    binMin[track] = childMin < binMin[track] ? childMin : binMin[track];
+                    binSum[track] += childSum;
+                    binMax[track] = childMax > binMax[track] ? childMax : binMax[track];
+                }
+            }
+
+            long long columnsInBin = (bin + 1) * binSize <= alignmentLength ? binSize : alignmentLength - bin * binSize;
+
+            for (int track = 0; track < ALIFILTER_PYRAMID_TRACK_COUNT; track++) {
+                binStats[track * 3] = binMin[track];
+                binStats[track * 3 + 1] = binSum[track];
+                binStats[track * 3 + 2] = binMax[track];
+
+                floatStats[(bin * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3] = (float)binMin[track];
+                floatStats[(bin * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3 + 1] = (float)(binSum[track] / columnsInBin);
+                floatStats[(bin * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3 + 2] = (float)binMax[track];
+            }
+        }
+
+        size_t valueCount = (size_t)binCount * ALIFILTER_PYRAMID_TRACK_COUNT * 3;
+        alifilter_pyramid_swapFloats(floatStats, valueCount);
+
+        if (fwrite(floatStats, sizeof(float), valueCount, fileH) != valueCount) {
+            result = 4;
+        }
+
+        previousBinCount = binCount;
+    }
+
+    free(stats);
+    free(floatStats);
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+int alifilter_openPyramid(const char* pyramidFile, alifilter_pyramid* out_pyramid) {
+    const unsigned char* data = NULL;
+    unsigned long long size = 0;
+    void* fileHandle = NULL;
+    void* mappingHandle = NULL;
+
+#ifdef _WIN32
+    HANDLE winFile = CreateFileA(pyramidFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+
+    if (winFile == INVALID_HANDLE_VALUE) {
+        return 1;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(winFile, &fileSize)) {
+        CloseHandle(winFile);
+        return 1;
+    }
+
+    if (fileSize.QuadPart < ALIFILTER_PYRAMID_HEADER_SIZE) {
+        CloseHandle(winFile);
+        return 2;
+    }
+
+    HANDLE winMapping = CreateFileMappingA(winFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    data = winMapping != NULL ? (const unsigned char*)MapViewOfFile(winMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    if (data == NULL) {
+        if (winMapping != NULL) {
+            CloseHandle(winMapping);
+        }
+
+        CloseHandle(winFile);
+        return 1;
+    }
+
+    size = (unsigned long long)fileSize.QuadPart;
+    fileHandle = winFile;
+    mappingHandle = winMapping;
+#else
+    int fileDescriptor = open(pyramidFile, O_RDONLY);
+
+    if (fileDescriptor < 0) {
+        return 1;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        close(fileDescriptor);
+        return 1;
+    }
+
+    if (fileStat.st_size < ALIFILTER_PYRAMID_HEADER_SIZE) {
+        close(fileDescriptor);
+        return 2;
+    }
+
+    void* mapped = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+
+    // The mapping remains valid after the file descriptor is closed.
+    close(fileDescriptor);
+
+    if (mapped == MAP_FAILED) {
+        return 1;
+    }
+
+    data = (const unsigned char*)mapped;
+    size = (unsigned long long)fileStat.st_size;
+#endif
+
+    out_pyramid->data = data;
+    out_pyramid->size = size;
+    out_pyramid->fileHandle = fileHandle;
+    out_pyramid->mappingHandle = mappingHandle;
+
+    // Validate the header and the level table.
+    int valid = memcmp(data, "AFPY", 4) == 0 && alifilter_pyramid_getUInt(data + 4, 4) == 1 && alifilter_pyramid_getUInt(data + 8, 4) == ALIFILTER_PYRAMID_TRACK_COUNT;
+    uint64_t levelCount = alifilter_pyramid_getUInt(data + 12, 4);
+    uint64_t columnCount = alifilter_pyramid_getUInt(data + 16, 8);
+
+    valid = valid && levelCount > 0 && levelCount < 64 && columnCount <= 0x7FFFFFFF && ALIFILTER_PYRAMID_HEADER_SIZE + levelCount * 24 <= size;
+
+    uint64_t binCount = columnCount;
+    uint64_t binSize = 1;
+
+    for (uint64_t level = 0; level < levelCount && valid; level++) {
+        const unsigned char* entry = data + ALIFILTER_PYRAMID_HEADER_SIZE + level * 24;
+        uint64_t offset = alifilter_pyramid_getUInt(entry, 8);
+
+        valid = alifilter_pyramid_getUInt(entry + 8, 8) == binCount && alifilter_pyramid_getUInt(entry + 16, 8) == binSize && offset % sizeof(float) == 0 &&
+            offset <= size && binCount * ALIFILTER_PYRAMID_TRACK_COUNT * (level == 0 ? 1 : 3) * sizeof(float) <= size - offset;
+
+        binCount = (binCount + ALIFILTER_PYRAMID_FACTOR - 1) / ALIFILTER_PYRAMID_FACTOR;
+        binSize *= ALIFILTER_PYRAMID_FACTOR;
+    }
+
+    if (!valid) {
+        alifilter_closePyramid(out_pyramid);
+        return 2;
+    }
+
+    out_pyramid->columnCount = (long long)columnCount;
+    out_pyramid->levelCount = (int)levelCount;
+
+    return 0;
+}
+
+void alifilter_closePyramid(alifilter_pyramid* pyramid) {
+    if (pyramid->data == NULL) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(pyramid->data);
+    CloseHandle((HANDLE)pyramid->mappingHandle);
+    CloseHandle((HANDLE)pyramid->fileHandle);
+#else
+    munmap((void*)pyramid->data, (size_t)pyramid->size);
+#endif
+
+    pyramid->data = NULL;
+    pyramid->size = 0;
+}
+
+long long alifilter_getPyramidBinSize(const alifilter_pyramid* pyramid, int level) {
+    if (level < 0 || level >= pyramid->levelCount) {
+        return -1;
+    }
+
+    return (long long)alifilter_pyramid_getUInt(pyramid->data + ALIFILTER_PYRAMID_HEADER_SIZE + level * 24 + 16, 8);
+}
+
+long long alifilter_getPyramidBinCount(const alifilter_pyramid* pyramid, int level) {
+    if (level < 0 || level >= pyramid->levelCount) {
+        return -1;
+    }
+
+    return (long long)alifilter_pyramid_getUInt(pyramid->data + ALIFILTER_PYRAMID_HEADER_SIZE + level * 24 + 8, 8);
+}
+
+int alifilter_selectPyramidLevel(const alifilter_pyramid* pyramid, long long firstColumn, long long columnCount, int maxBins) {
+    if (maxBins < 1) {
+        maxBins = 1;
+    }
+
+    for (int level = 0; level < pyramid->levelCount; level++) {
+        long long binSize = alifilter_getPyramidBinSize(pyramid, level);
+
+        // Number of bins that overlap the range.
+        long long bins = columnCount > 0 ? (firstColumn + columnCount - 1) / binSize - firstColumn / binSize + 1 : 0;
+
+        if (bins <= maxBins) {
+            return level;
+        }
+    }
+
+    return pyramid->levelCount - 1;
+}
+
+int alifilter_queryPyramid(const alifilter_pyramid* pyramid, int level, long long firstBin, int binCount, float* out_stats) {
+    long long levelBinCount = alifilter_getPyramidBinCount(pyramid, level);
+
+    if (levelBinCount < 0 || firstBin < 0 || firstBin > levelBinCount || binCount < 0) {
+        return -1;
+    }
+
+    if (binCount > levelBinCount - firstBin) {
+        binCount = (int)(levelBinCount - firstBin);
+    }
+
+    uint64_t offset = alifilter_pyramid_getUInt(pyramid->data + ALIFILTER_PYRAMID_HEADER_SIZE + level * 24, 8);
+
+    if (level == 0) {
+        const unsigned char* levelData = pyramid->data + offset + (size_t)firstBin * ALIFILTER_PYRAMID_TRACK_COUNT * sizeof(float);
+
+        for (int i = 0; i < binCount * ALIFILTER_PYRAMID_TRACK_COUNT; i++) {
+            float value;
+            memcpy(&value, levelData + (size_t)i * sizeof(float), sizeof(float));
+            alifilter_pyramid_swapFloats(&value, 1);
+
+            out_stats[i * 3] = value;
+            out_stats[i * 3 + 1] = value;
+            out_stats[i * 3 + 2] = value;
+        }
+    }
+    else {
+        // The bins are stored in the same layout as the output.
+        size_t valueCount = (size_t)binCount * ALIFILTER_PYRAMID_TRACK_COUNT * 3;
+        memcpy(out_stats, pyramid->data + offset + (size_t)firstBin * ALIFILTER_PYRAMID_TRACK_COUNT * 3 * sizeof(float), valueCount * sizeof(float));
+        alifilter_pyramid_swapFloats(out_stats, valueCount);
+    }
+
+    return binCount;
+}
+
+#endif
+#endif
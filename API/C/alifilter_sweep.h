@@ -0,0 +1,733 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_SWEEP_H
+#define ALIFILTER_SWEEP_H
+
+// Label-noise robustness sweep. The "--mistakes" option of the AliFilter command-line program randomly changes a
+// proportion of the training labels, to simulate errors in the training dataset; exploring how robust the training is
+// requires training and validating a model for each proportion of mistakes (and for several random draws). This file
+// reads a feature file created by the command-line program once, and then trains and validates a model for each point
+// of a grid of mistake rates and replicates, distributing the grid points over a pool of threads.
+//
+// The noisy labels are generated with a counter-based random number generator: whether the label of a column is changed
+// only depends on the seed, the replicate and the column index, so the results do not depend on the number of threads
+// or on the order in which the grid points are processed, and no random state is shared between the threads. Each label
+// is changed independently with probability equal to the mistake rate (rather than changing exactly that proportion of
+// the labels, like the command-line program); for the same replicate, the labels that are changed at a lower mistake
+// rate are also changed at all higher rates, which reduces the noise when comparing different rates.
+//
+// The models are trained using alifilter_train.h (the logistic model only, as the linear discriminant analysis does not
+// affect the scores), and validated against the original labels of the validation data (or of the training data, if no
+// separate validation data are provided). The scores are compared to the thresholds using the same rule as the
+// "validate" task (i.e., a column is preserved if its score is strictly greater than the threshold; note that
+// alifilter_computeMaskFromScores also preserves columns whose score is equal to the threshold).
+//
+// This requires the implementations from alifilter.h, alifilter_mask.h, alifilter_threads.h and alifilter_train.h, and
+// the zlib library (link with -lz).
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alifilter.h"
+#include "alifilter_threads.h"
+#include "alifilter_train.h"
+
+// Represents the features and labels read from a feature file.
+typedef struct {
+    // Number of columns.
+    int columnCount;
+
+    // Features for each column (columnCount * ALIFILTER_FEATURE_COUNT elements).
+    double* features;
+
+    // Label for each column ('1' if the column should be preserved, '0' if it should be removed); this is not
+    // null-terminated.
+    char* mask;
+} alifilter_featureMatrix;
+
+// Results of training and validating a model for one point of the grid.
+typedef struct {
+    // Proportion of labels that were randomly changed.
+    double mistakeRate;
+
+    // Index of the replicate for this mistake rate.
+    int replicate;
+
+    // 0 if the model was trained and validated successfully, 2 if the model could not be fitted, 3 if there was not
+    // enough memory. If this is not 0, only the previous fields are valid.
+    int result;
+
+    // Number of columns whose label was changed from removed to preserved, and from preserved to removed.
+    int incorrectlyPreserved;
+    int incorrectlyDeleted;
+
+    // The trained model (with a threshold of 0.5).
+    alifilter_model model;
+
+    // Confusion matrix on the validation data, using the threshold of the model.
+    int truePositives;
+    int trueNegatives;
+    int falsePositives;
+    int falseNegatives;
+
+    // Accuracy and Matthews correlation coefficient on the validation data, using the threshold of the model.
+    double accuracy;
+    double mcc;
+
+    // Threshold between 0.01 and 0.99 (in steps of 0.01) that gives the highest Matthews correlation coefficient on the
+    // validation data, and the corresponding coefficient.
+    double bestThreshold;
+    double bestMCC;
+} alifilter_sweepResult;
+
+// Reads the features and labels from a feature file created by the AliFilter command-line program ("AliFilter --mask
+// <input mask> -o <output feature file>", possibly with the features of multiple alignments). Bootstrap replicates are
+// skipped, and columns with non-finite features (in the column or in any of its bootstrap replicates) are ignored, as
+// in the command-line program.
+//   Parameters:
+//     • const char* featureFile: the path to the feature file.
+//     • alifilter_featureMatrix* out_features: if the return value is 0 or 5, when this function returns this will contain
+//                                              the features and labels (which should be freed using
+//                                              alifilter_freeFeatureMatrix).
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the file is not a valid feature file, or it contains a different set of features (or no valid columns), or it
+//          was created by a version of the program whose features are not compatible (as in Features.FeaturesCompatible
+//          in the C# library)
+//     • 3: could not allocate enough memory for the features
+//     • 4: error while reading the file
+//     • 5: error while closing the file (but the features have been read successfully and should be freed)
+int alifilter_readFeatureFile(const char* featureFile, alifilter_featureMatrix* out_features);
+
+// Frees the memory used by a feature matrix.
+void alifilter_freeFeatureMatrix(alifilter_featureMatrix* features);
+
+// Trains and validates a model for each combination of mistake rate and replicate.
+//   Parameters:
+//     • const alifilter_featureMatrix* trainingData: the training features and labels. These are shared by all the grid
+//                                                   points, and are not modified.
+//     • const alifilter_featureMatrix* validationData: the validation features and labels, or NULL to validate the
+//                                                     models against the original labels of the training data.
+//     • const double* mistakeRates: the proportions of labels to change (between 0 and 1).
+//     • int rateCount: the number of mistake rates.
+//     • int replicateCount: the number of replicates for each mistake rate.
+//     • uint64_t seed: the seed for the random number generator.
+//     • int threadCount: the maximum number of threads to use. If this is less than or equal to 0, one thread per
+//                        processor is used.
+//     • alifilter_sweepResult* out_results: a pointer to an array containing at least rateCount * replicateCount
+//                                           elements, which will be populated with the results. The result for replicate
+//                                           j of mistake rate i is at index i * replicateCount + j.
+//
+//   Return value:
+//     • 0: success (the result field of each element of out_results should also be checked)
+//     • 2: invalid parameters (e.g., a mistake rate that is not between 0 and 1, or empty training or validation data)
+int alifilter_runMistakeSweep(const alifilter_featureMatrix* trainingData, const alifilter_featureMatrix* validationData, const double* mistakeRates, int rateCount, int replicateCount, uint64_t seed, int threadCount, alifilter_sweepResult* out_results);
+
+// Writes the results of a sweep as a tab-separated table, with one row for each grid point.
+//   Parameters:
+//     • FILE* fileH: the file to write to (e.g., stdout).
+//     • const alifilter_sweepResult* results: the results.
+//     • int resultCount: the number of results.
+//
+//   Return value: 0 on success, 4 if an error occurred while writing.
+int alifilter_writeSweepResults(FILE* fileH, const alifilter_sweepResult* results, int resultCount);
+
+#ifdef ALIFILTER_SWEEP_IMPLEMENTATION
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifndef MIN
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+// Size of the buffer for the decompressed data.
+#define ALIFILTER_SWEEP_BUFFER_SIZE 65536
+
+// Number of threshold steps between 0 and 1 when tuning the threshold (the same as the "validate" task).
+#define ALIFILTER_SWEEP_THRESHOLD_STEPS 101
+
+// Checks whether features computed by the specified version of the command-line program are compatible with this
+// implementation, like Features.FeaturesCompatible in the C# library: the version is parsed like a .NET Version
+// (2 to 4 non-negative integers separated by dots), and the features are compatible if the upper 16 bits of the
+// fourth component (the MajorRevision) are at most 1, or if there is no fourth component.
+//   Return value: 1 if the features are compatible, 0 otherwise (including if the version cannot be parsed).
+static int alifilter_sweep_featuresCompatible(const char* programVersion) {
+    long long components[4];
+    int componentCount = 0;
+    const char* c = programVersion;
+
+    while (componentCount < 4) {
+        if (*c < '0' || *c > '9') {
+            return 0;
+        }
+
+        long long value = 0;
+
+        while (*c >= '0' && *c <= '9') {
+            value = value * 10 + (*c - '0');
+
+            if (value > 0x7FFFFFFF) {
+                return 0;
+            }
+
+            c++;
+        }
+
+        components[componentCount++] = value;
+
+        if (*c != '.') {
+            break;
+        }
+
+        c++;
+    }
+
+    if (*c != 0 || componentCount < 2) {
+        return 0;
+    }
+
+    return componentCount < 4 || (components[3] >> 16) <= 1;
+}
+
+// Decompresses one of the gzip streams in a feature file.
+typedef struct {
+    z_stream stream;
+    unsigned char buffer[ALIFILTER_SWEEP_BUFFER_SIZE];
+    size_t position;
+    size_t length;
+    int finished;
+} alifilter_sweep_inflater;
+
+// Reads bytes from the decompressed stream.
+//   Parameters:
+//     • alifilter_sweep_inflater* inflater: the decompressor.
+//     • unsigned char* out_data: the buffer for the data, or NULL to skip the bytes.
+//     • size_t count: the number of bytes to read.
+//
+//   Return value: the number of bytes that have been read (less than count if the stream has ended), or -1 if the
+//   compressed data are not valid.
+static long long alifilter_sweep_read(alifilter_sweep_inflater* inflater, unsigned char* out_data, size_t count) {
+    size_t read = 0;
+
+    while (read < count) {
+        if (inflater->position == inflater->length) {
+            if (inflater->finished) {
+                break;
+            }
+
+            inflater->stream.next_out = inflater->buffer;
+            inflater->stream.avail_out = ALIFILTER_SWEEP_BUFFER_SIZE;
+
+            int result = inflate(&inflater->stream, Z_NO_FLUSH);
+
+            if (result == Z_STREAM_END) {
+                inflater->finished = 1;
+            }
+            else if (result != Z_OK) {
+                return -1;
+            }
+
+            inflater->position = 0;
+            inflater->length = ALIFILTER_SWEEP_BUFFER_SIZE - inflater->stream.avail_out;
+
+            // The input has been exhausted before the end of the stream.
+            if (inflater->length == 0 && !inflater->finished) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        size_t available = MIN(inflater->length - inflater->position, count - read);
+
+        if (out_data != NULL) {
+            memcpy(out_data + read, inflater->buffer + inflater->position, available);
+        }
+
+        inflater->position += available;
+        read += available;
+    }
+
+    return (long long)read;
+}
+
+// Reads a string written by the .NET BinaryWriter (prefixed by its length, encoded 7 bits at a time). Strings longer
+// than the buffer are skipped, and out_string is set to an empty string.
+//   Return value: 0 on success, or 2 if the data are not valid.
+static int alifilter_sweep_readString(alifilter_sweep_inflater* inflater, char* out_string, int capacity) {
+    size_t length = 0;
+
+    for (int shift = 0; ; shift += 7) {
+        unsigned char byte;
+
+        if (shift > 28 || alifilter_sweep_read(inflater, &byte, 1) != 1) {
+            return 2;
+        }
+
+        length |= (size_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+
+    int fits = length < (size_t)capacity;
+
+    if (alifilter_sweep_read(inflater, fits ? (unsigned char*)out_string : NULL, length) != (long long)length) {
+        return 2;
+    }
+
+    out_string[fits ? length : 0] = '\0';
+
+    return 0;
+}
+
+// Reads the columns from one of the gzip streams in a feature file, appending them to the feature matrix.
+//   Return value: 0 on success, 2 if the data are not valid, 3 if there is not enough memory.
+static int alifilter_sweep_readStream(const unsigned char* compressedData, size_t compressedLength, alifilter_featureMatrix* features, int* capacity) {
+    alifilter_sweep_inflater* inflater = (alifilter_sweep_inflater*)malloc(sizeof(alifilter_sweep_inflater));
+
+    if (inflater == NULL) {
+        return 3;
+    }
+
+    memset(&inflater->stream, 0, sizeof(z_stream));
+    inflater->position = 0;
+    inflater->length = 0;
+    inflater->finished = 0;
+
+    // gzip format (window bits + 16).
+    if (inflateInit2(&inflater->stream, 15 + 16) != Z_OK) {
+        free(inflater);
+        return 3;
+    }
+
+    inflater->stream.next_in = (Bytef*)compressedData;
+    inflater->stream.avail_in = (uInt)compressedLength;
+
+    char programVersion[64];
+    char featureSignature[64];
+    unsigned char replicateCountBytes[4];
+    int result = 0;
+
+    if (alifilter_sweep_readString(inflater, programVersion, sizeof(programVersion)) != 0 || !alifilter_sweep_featuresCompatible(programVersion) ||
+        alifilter_sweep_readString(inflater, featureSignature, sizeof(featureSignature)) != 0 || strcmp(featureSignature, ALIFILTER_FEATURE_SIGNATURE) != 0 ||
+        alifilter_sweep_read(inflater, replicateCountBytes, 4) != 4) {
+        result = 2;
+    }
+
+    int replicateCount = (int)(replicateCountBytes[0] | (replicateCountBytes[1] << 8) | (replicateCountBytes[2] << 16) | ((unsigned int)replicateCountBytes[3] << 24));
+
+    if (result == 0 && replicateCount < 0) {
+        result = 2;
+    }
+
+    // Each column contains a boolean, followed by the value and the bootstrap replicates for each feature.
+    size_t columnSize = 1 + (size_t)ALIFILTER_FEATURE_COUNT * (replicateCount + 1) * 8;
+    unsigned char* column = result == 0 ? (unsigned char*)malloc(columnSize) : NULL;
+
+    if (result == 0 && column == NULL) {
+        result = 3;
+    }
+
+    while (result == 0) {
+        long long read = alifilter_sweep_read(inflater, column, columnSize);
+
+        if (read == 0) {
+            break;
+        }
+        else if (read != (long long)columnSize) {
+            result = 2;
+            break;
+        }
+
+        double values[ALIFILTER_FEATURE_COUNT];
+        int allFinite = 1;
+
+        for (int i = 0; i < ALIFILTER_FEATURE_COUNT; i++) {
+            for (int j = 0; j < replicateCount + 1; j++) {
+                const unsigned char* source = column + 1 + ((size_t)i * (replicateCount + 1) + j) * 8;
+                uint64_t bits = 0;
+
+                for (int k = 0; k < 8; k++) {
+                    bits |= (uint64_t)source[k] << (8 * k);
+                }
+
+                double value;
+                memcpy(&value, &bits, sizeof(double));
+
+                if (!isfinite(value)) {
+                    allFinite = 0;
+                }
+
+                if (j == 0) {
+                    values[i] = value;
+                }
+            }
+        }
+
+        if (!allFinite) {
+            continue;
+        }
+
+        if (features->columnCount == *capacity) {
+            if (*capacity >= 0x3FFFFFFF) {
+                result = 3;
+                break;
+            }
+
+            int newCapacity = *capacity == 0 ? 1024 : *capacity * 2;
+            double* newFeatures = (double*)realloc(features->features, (size_t)newCapacity * ALIFILTER_FEATURE_COUNT * sizeof(double));
+
+            if (newFeatures == NULL) {
+                result = 3;
+                break;
+            }
+
+            features->features = newFeatures;
+
+            char* newMask = (char*)realloc(features->mask, (size_t)newCapacity * sizeof(char));
+
+            if (newMask == NULL) {
+                result = 3;
+                break;
+            }
+
+            features->mask = newMask;
+            *capacity = newCapacity;
+        }
+
+        memcpy(&features->features[(size_t)features->columnCount * ALIFILTER_FEATURE_COUNT], values, sizeof(values));
+        features->mask[features->columnCount] = column[0] != 0 ? '1' : '0';
+        features->columnCount++;
+    }
+
+    free(column);
+    inflateEnd(&inflater->stream);
+    free(inflater);
+
+    return result;
+}
+
+int alifilter_readFeatureFile(const char* featureFile, alifilter_featureMatrix* out_features) {
+    FILE* fileH = fopen(featureFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    memset(out_features, 0, sizeof(alifilter_featureMatrix));
+
+    int capacity = 0;
+    int result = 0;
+    unsigned char* compressedData = NULL;
+    size_t compressedCapacity = 0;
+
+    // The file contains one or more gzip streams (one for each alignment), each preceded by its length.
+    while (result == 0) {
+        unsigned char lengthBytes[8];
+        size_t read = fread(lengthBytes, 1, 8, fileH);
+
+        if (read == 0 && !ferror(fileH)) {
+            break;
+        }
+        else if (read != 8) {
+            result = ferror(fileH) ? 4 : 2;
+            break;
+        }
+
+        uint64_t length = 0;
+
+        for (int i = 0; i < 8; i++) {
+            length |= (uint64_t)lengthBytes[i] << (8 * i);
+        }
+
+        if (length == 0 || length > 0x7FFFFFFF) {
+            result = 2;
+            break;
+        }
+
+        if (length > compressedCapacity) {
+            unsigned char* newData = (unsigned char*)realloc(compressedData, (size_t)length);
+
+            if (newData == NULL) {
+                result = 3;
+                break;
+            }
+
+            compressedData = newData;
+            compressedCapacity = (size_t)length;
+        }
+
+        if (fread(compressedData, 1, (size_t)length, fileH) != (size_t)length) {
+            result = ferror(fileH) ? 4 : 2;
+            break;
+        }
+
+        result = alifilter_sweep_readStream(compressedData, (size_t)length, out_features, &capacity);
+    }
+
+    free(compressedData);
+
+    if (result == 0 && out_features->columnCount == 0) {
+        result = 2;
+    }
+
+    if (result != 0) {
+        alifilter_freeFeatureMatrix(out_features);
+        fclose(fileH);
+        return result;
+    }
+
+    if (fclose(fileH) != 0) {
+        return 5;
+    }
+
+    return 0;
+}
+
+void alifilter_freeFeatureMatrix(alifilter_featureMatrix* features) {
+    free(features->features);
+    free(features->mask);
+    features->features = NULL;
+    features->mask = NULL;
+    features->columnCount = 0;
+}
+
+// Finalisation function from SplitMix64.
+static uint64_t alifilter_sweep_mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Counter-based random number generator: returns a uniformly distributed number in [0, 1) that only depends on the key
+// and on the counter.
+static double alifilter_sweep_random(uint64_t key, uint64_t counter) {
+    return (alifilter_sweep_mix(key + 0x9E3779B97F4A7C15ULL * (counter + 1)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Computes the Matthews correlation coefficient (handling the degenerate cases like Utilities.ComputeMCC in the C#
+// program).
+static double alifilter_sweep_computeMCC(int tp, int tn, int fp, int fn) {
+    if (tn + fp + fn == 0 || tp + fp + fn == 0) {
+        return 1;
+    }
+    else if (tp + fp == 0 || tp + fn == 0 || tn + fp == 0 || tn + fn == 0) {
+        return 0;
+    }
+    else {
+        return ((double)tp * tn - (double)fp * fn) / sqrt(((double)tp + fp) * ((double)tp + fn) * ((double)tn + fp) * ((double)tn + fn));
+    }
+}
+
+// State shared by the threads taking part in a sweep.
+typedef struct {
+    const alifilter_featureMatrix* trainingData;
+    const alifilter_featureMatrix* validationData;
+    const double* mistakeRates;
+    int replicateCount;
+    uint64_t seed;
+    alifilter_sweepResult* results;
+} alifilter_sweep_state;
+
+// Trains and validates the model for one grid point (body of alifilter_parallelFor).
+static void alifilter_sweep_runGridPoint(int index, void* state) {
+    alifilter_sweep_state* sweep = (alifilter_sweep_state*)state;
+    alifilter_sweepResult* result = &sweep->results[index];
+
+    const alifilter_featureMatrix* training = sweep->trainingData;
+    const alifilter_featureMatrix* validation = sweep->validationData;
+
+    memset(result, 0, sizeof(alifilter_sweepResult));
+    result->mistakeRate = sweep->mistakeRates[index / sweep->replicateCount];
+    result->replicate = index % sweep->replicateCount;
+
+    char* noisyMask = (char*)malloc((size_t)training->columnCount * sizeof(char));
+    double* scores = (double*)malloc((size_t)validation->columnCount * sizeof(double));
+
+    if (noisyMask == NULL || scores == NULL) {
+        free(noisyMask);
+        free(scores);
+        result->result = 3;
+        return;
+    }
+
+    // The key only depends on the replicate, so that the same columns are drawn for all the mistake rates.
+    uint64_t key = alifilter_sweep_mix(sweep->seed ^ alifilter_sweep_mix((uint64_t)result->replicate + 1));
+
+    for (int i = 0; i < training->columnCount; i++) {
+        int preserved = training->mask[i] == '1';
+
+        if (alifilter_sweep_random(key, (uint64_t)i) < result->mistakeRate) {
+            preserved = !preserved;
+
+            if (preserved) {
+                result->incorrectlyPreserved++;
+            }
+            else {
+                result->incorrectlyDeleted++;
+            }
+        }
+
+        noisyMask[i] = preserved ? '1' : '0';
+    }
+
+    alifilter_trainer trainer;
+    alifilter_initTrainer(&trainer);
+
+    result->result = alifilter_updateTrainer(&trainer, training->features, noisyMask, training->columnCount);
+    free(noisyMask);
+
+    if (result->result != 0) {
+        free(scores);
+        return;
+    }
+
+    alifilter_getTrainerModel(&trainer, &result->model);
+    alifilter_computeScores(result->model, validation->features, validation->columnCount, scores);
+
+    // Number of columns in each class whose score is between consecutive threshold steps (the column is preserved when
+    // the threshold is k / 100 for all 1 <= k <= step).
+    int classCounts[2][ALIFILTER_SWEEP_THRESHOLD_STEPS] = { { 0 } };
+
+    for (int i = 0; i < validation->columnCount; i++) {
+        int label = validation->mask[i] == '1';
+        int predicted = scores[i] > result->model.threshold;
+
+        if (predicted && label) {
+            result->truePositives++;
+        }
+        else if (predicted) {
+            result->falsePositives++;
+        }
+        else if (label) {
+            result->falseNegatives++;
+        }
+        else {
+            result->trueNegatives++;
+        }
+
+        int step = scores[i] > 0 ? (int)MIN(floor(scores[i] * (ALIFILTER_SWEEP_THRESHOLD_STEPS - 1)), ALIFILTER_SWEEP_THRESHOLD_STEPS - 1) : 0;
+
+        // Correct for rounding errors (and for scores that are exactly equal to a threshold step), so that the comparison
+        // is the same as scores[i] > k / 100.
+        while (step < ALIFILTER_SWEEP_THRESHOLD_STEPS - 1 && scores[i] > (double)(step + 1) / (ALIFILTER_SWEEP_THRESHOLD_STEPS - 1)) {
+            step++;
+        }
+
+        while (step > 0 && !(scores[i] > (double)step / (ALIFILTER_SWEEP_THRESHOLD_STEPS - 1))) {
+            step--;
+        }
+
+        classCounts[label][step]++;
+    }
+
+    free(scores);
+
+    result->accuracy = ((double)result->truePositives + result->trueNegatives) / validation->columnCount;
+    result->mcc = alifilter_sweep_computeMCC(result->truePositives, result->trueNegatives, result->falsePositives, result->falseNegatives);
+
+    // Tune the threshold, excluding 0 and 1 (like the "validate" task).
+    int positives = 0;
+    int negatives = 0;
+
+    for (int k = 0; k < ALIFILTER_SWEEP_THRESHOLD_STEPS; k++) {
+        positives += classCounts[1][k];
+        negatives += classCounts[0][k];
+    }
+
+    int tp = classCounts[1][ALIFILTER_SWEEP_THRESHOLD_STEPS - 1];
+    int fp = classCounts[0][ALIFILTER_SWEEP_THRESHOLD_STEPS - 1];
+
+    result->bestMCC = -2;
+
+    for (int k = ALIFILTER_SWEEP_THRESHOLD_STEPS - 2; k >= 1; k--) {
+        tp += classCounts[1][k];
+        fp += classCounts[0][k];
+
+        double mcc = alifilter_sweep_computeMCC(tp, negatives - fp, fp, positives - tp);
+
+        // Ties are resolved in favour of the lowest threshold, as in the "validate" task.
+        if (mcc >= result->bestMCC) {
+            result->bestMCC = mcc;
+            result->bestThreshold = (double)k / (ALIFILTER_SWEEP_THRESHOLD_STEPS - 1);
+        }
+    }
+}
+
+int alifilter_runMistakeSweep(const alifilter_featureMatrix* trainingData, const alifilter_featureMatrix* validationData, const double* mistakeRates, int rateCount, int replicateCount, uint64_t seed, int threadCount, alifilter_sweepResult* out_results) {
+    if (validationData == NULL) {
+        validationData = trainingData;
+    }
+
+    if (rateCount <= 0 || replicateCount <= 0 || rateCount > 0x7FFFFFFF / replicateCount || trainingData->columnCount <= 0 || validationData->columnCount <= 0) {
+        return 2;
+    }
+
+    for (int i = 0; i < rateCount; i++) {
+        if (!(mistakeRates[i] >= 0 && mistakeRates[i] <= 1)) {
+            return 2;
+        }
+    }
+
+    alifilter_sweep_state state;
+    state.trainingData = trainingData;
+    state.validationData = validationData;
+    state.mistakeRates = mistakeRates;
+    state.replicateCount = replicateCount;
+    state.seed = seed;
+    state.results = out_results;
+
+    alifilter_parallelFor(rateCount * replicateCount, threadCount, alifilter_sweep_runGridPoint, &state);
+
+    return 0;
+}
+
+int alifilter_writeSweepResults(FILE* fileH, const alifilter_sweepResult* results, int resultCount) {
+    int ok = fprintf(fileH, "MistakeRate\tReplicate\tResult\tIncorrectlyPreserved\tIncorrectlyDeleted\tTP\tTN\tFP\tFN\tAccuracy\tMCC\tBestThreshold\tBestMCC\n") >= 0;
+
+    for (int i = 0; i < resultCount && ok; i++) {
+        const alifilter_sweepResult* result = &results[i];
+
+        if (result->result == 0) {
+            ok = fprintf(fileH, "%.6g\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%.6f\t%.6f\t%.2f\t%.6f\n", result->mistakeRate, result->replicate, result->result,
+                result->incorrectlyPreserved, result->incorrectlyDeleted, result->truePositives, result->trueNegatives, result->falsePositives,
+                result->falseNegatives, result->accuracy, result->mcc, result->bestThreshold, result->bestMCC) >= 0;
+        }
+        else {
+            ok = fprintf(fileH, "%.6g\t%d\t%d\t\t\t\t\t\t\t\t\t\t\n", result->mistakeRate, result->replicate, result->result) >= 0;
+        }
+    }
+
+    return ok ? 0 : 4;
+}
+
+#endif
+#endif
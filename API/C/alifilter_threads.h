@@ -0,0 +1,447 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_THREADS_H
+#define ALIFILTER_THREADS_H
+
+// Executes a function for each index between 0 (inclusive) and count (exclusive), distributing the indices over a pool
+// of threads. The calling thread also takes part in the work, and the function returns when all the indices have been
+// processed. Indices are handed out in increasing order, one at a time, so this is suitable for coarse-grained work
+// items (e.g., one alignment or one block of data per index).
+//
+// The worker threads are created the first time they are needed, and they are kept waiting for work between calls, so
+// that repeated calls (e.g., one for each batch of data) do not pay for creating and joining threads. The pool grows to
+// the largest threadCount that has been requested. The pool runs one call at a time: if it is already busy (because
+// another thread is using it, or because body itself calls alifilter_parallelFor), the call uses temporary threads
+// that are joined before it returns.
+//   Parameters:
+//     • int count: the number of indices to process.
+//     • int threadCount: the maximum number of threads to use (including the calling thread). If this is less than or
+//                        equal to 0, one thread per processor is used.
+//     • void (*body)(int index, void* state): the function to execute for each index.
+//     • void* state: a pointer that is passed unchanged to each invocation of body.
+void alifilter_parallelFor(int count, int threadCount, void (*body)(int index, void* state), void* state);
+
+// Stops the worker threads of the pool and waits for them to terminate (waiting first for a running
+// alifilter_parallelFor call to finish, if necessary). This is only needed before unloading a shared library that
+// contains the implementation, or to release the threads before the program exits; the pool is created again if
+// alifilter_parallelFor is called afterwards.
+void alifilter_stopThreadPool(void);
+
+// Returns the number of processors that are available to the program (at least 1).
+int alifilter_getProcessorCount(void);
+
+#ifdef ALIFILTER_THREADS_IMPLEMENTATION
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Lock and condition variables used by the pool.
+#ifdef _WIN32
+static SRWLOCK alifilter_threads_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE alifilter_threads_workAvailable = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE alifilter_threads_workFinished = CONDITION_VARIABLE_INIT;
+
+#define ALIFILTER_THREADS_LOCK() AcquireSRWLockExclusive(&alifilter_threads_lock)
+#define ALIFILTER_THREADS_UNLOCK() ReleaseSRWLockExclusive(&alifilter_threads_lock)
+#define ALIFILTER_THREADS_WAIT(condition) SleepConditionVariableSRW(&(condition), &alifilter_threads_lock, INFINITE, 0)
+#define ALIFILTER_THREADS_BROADCAST(condition) WakeAllConditionVariable(&(condition))
+#else
+static pthread_mutex_t alifilter_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t alifilter_threads_workAvailable = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t alifilter_threads_workFinished = PTHREAD_COND_INITIALIZER;
+
+#define ALIFILTER_THREADS_LOCK() pthread_mutex_lock(&alifilter_threads_lock)
+#define ALIFILTER_THREADS_UNLOCK() pthread_mutex_unlock(&alifilter_threads_lock)
+#define ALIFILTER_THREADS_WAIT(condition) pthread_cond_wait(&(condition), &alifilter_threads_lock)
+#define ALIFILTER_THREADS_BROADCAST(condition) pthread_cond_broadcast(&(condition))
+#endif
+
+// A call to alifilter_parallelFor that is being run by the pool.
+typedef struct {
+    int count;
+    int nextIndex;
+    void (*body)(int index, void* state);
+    void* state;
+
+    // Maximum number of pool threads that can help the calling thread, and number of threads that have joined.
+    int maxHelpers;
+    int helpers;
+
+    // Number of pool threads that are still processing indices.
+    int activeHelpers;
+} alifilter_threads_job;
+
+// State of the pool (protected by alifilter_threads_lock).
+static struct {
+    // The job being run (NULL if the pool is idle).
+    alifilter_threads_job* job;
+
+    // Whether the pool is being used by an alifilter_parallelFor call.
+    int busy;
+
+    // Whether the worker threads should terminate.
+    int stopping;
+
+    // Worker threads.
+    int workerCount;
+    int workerCapacity;
+#ifdef _WIN32
+    HANDLE* workers;
+#else
+    pthread_t* workers;
+#endif
+} alifilter_threads_pool;
+
+// Processes indices of a job until there are none left. The lock must be held when this is called, and it is held
+// again when this returns (but not while body is running).
+static void alifilter_threads_runJob(alifilter_threads_job* job) {
+    while (job->nextIndex < job->count) {
+        int index = job->nextIndex++;
+
+        ALIFILTER_THREADS_UNLOCK();
+        job->body(index, job->state);
+        ALIFILTER_THREADS_LOCK();
+    }
+}
+
+// Main loop of the worker threads: waits for a job and helps with it.
+static void alifilter_threads_workerLoop(void) {
+    ALIFILTER_THREADS_LOCK();
+
+    while (!alifilter_threads_pool.stopping) {
+        alifilter_threads_job* job = alifilter_threads_pool.job;
+
+        if (job != NULL && job->nextIndex < job->count && job->helpers < job->maxHelpers) {
+            job->helpers++;
+            job->activeHelpers++;
+
+            alifilter_threads_runJob(job);
+
+            job->activeHelpers--;
+
+            if (job->activeHelpers == 0) {
+                ALIFILTER_THREADS_BROADCAST(alifilter_threads_workFinished);
+            }
+        }
+        else {
+            ALIFILTER_THREADS_WAIT(alifilter_threads_workAvailable);
+        }
+    }
+
+    ALIFILTER_THREADS_UNLOCK();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI alifilter_threads_workerStart(LPVOID unused) {
+    (void)unused;
+    alifilter_threads_workerLoop();
+    return 0;
+}
+#else
+static void* alifilter_threads_workerStart(void* unused) {
+    (void)unused;
+    alifilter_threads_workerLoop();
+    return NULL;
+}
+
+// In the child process after a fork, only the thread that called fork exists: forget the pool threads (and reset the
+// lock, which might have been held by one of them).
+static void alifilter_threads_resetAfterFork(void) {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t condition = PTHREAD_COND_INITIALIZER;
+
+    alifilter_threads_lock = lock;
+    alifilter_threads_workAvailable = condition;
+    alifilter_threads_workFinished = condition;
+
+    free(alifilter_threads_pool.workers);
+    alifilter_threads_pool.workers = NULL;
+    alifilter_threads_pool.workerCount = 0;
+    alifilter_threads_pool.workerCapacity = 0;
+    alifilter_threads_pool.job = NULL;
+    alifilter_threads_pool.busy = 0;
+    alifilter_threads_pool.stopping = 0;
+}
+#endif
+
+// Creates worker threads until there are at least workerCount of them (or until a thread cannot be created). The lock
+// must be held when this is called.
+static void alifilter_threads_ensureWorkers(int workerCount) {
+#ifndef _WIN32
+    static int forkHandlerRegistered = 0;
+
+    if (!forkHandlerRegistered) {
+        pthread_atfork(NULL, NULL, alifilter_threads_resetAfterFork);
+        forkHandlerRegistered = 1;
+    }
+#endif
+
+    if (workerCount > alifilter_threads_pool.workerCapacity) {
+#ifdef _WIN32
+        HANDLE* newWorkers = (HANDLE*)realloc(alifilter_threads_pool.workers, workerCount * sizeof(HANDLE));
+#else
+        pthread_t* newWorkers = (pthread_t*)realloc(alifilter_threads_pool.workers, workerCount * sizeof(pthread_t));
+#endif
+
+        if (newWorkers == NULL) {
+            return;
+        }
+
+        alifilter_threads_pool.workers = newWorkers;
+        alifilter_threads_pool.workerCapacity = workerCount;
+    }
+
+    while (alifilter_threads_pool.workerCount < workerCount) {
+#ifdef _WIN32
+        HANDLE worker = CreateThread(NULL, 0, alifilter_threads_workerStart, NULL, 0, NULL);
+
+        if (worker == NULL) {
+            return;
+        }
+
+        alifilter_threads_pool.workers[alifilter_threads_pool.workerCount++] = worker;
+#else
+        if (pthread_create(&alifilter_threads_pool.workers[alifilter_threads_pool.workerCount], NULL, alifilter_threads_workerStart, NULL) != 0) {
+            return;
+        }
+
+        alifilter_threads_pool.workerCount++;
+#endif
+    }
+}
+
+// State shared by the temporary threads taking part in an alifilter_parallelFor call (when the pool is busy).
+typedef struct {
+    int count;
+    int nextIndex;
+    void (*body)(int index, void* state);
+    void* state;
+
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} alifilter_parallelForState;
+
+// Processes indices until there are none left.
+static void alifilter_parallelForWorker(alifilter_parallelForState* parallelState) {
+    while (1) {
+#ifdef _WIN32
+        EnterCriticalSection(&parallelState->lock);
+        int index = parallelState->nextIndex++;
+        LeaveCriticalSection(&parallelState->lock);
+#else
+        pthread_mutex_lock(&parallelState->lock);
+        int index = parallelState->nextIndex++;
+        pthread_mutex_unlock(&parallelState->lock);
+#endif
+
+        if (index >= parallelState->count) {
+            break;
+        }
+
+        parallelState->body(index, parallelState->state);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI alifilter_parallelForThreadStart(LPVOID parallelState) {
+    alifilter_parallelForWorker((alifilter_parallelForState*)parallelState);
+    return 0;
+}
+#else
+static void* alifilter_parallelForThreadStart(void* parallelState) {
+    alifilter_parallelForWorker((alifilter_parallelForState*)parallelState);
+    return NULL;
+}
+#endif
+
+// Runs an alifilter_parallelFor call on temporary threads.
+static void alifilter_parallelForTemporary(int count, int threadCount, void (*body)(int index, void* state), void* state) {
+    alifilter_parallelForState parallelState;
+    parallelState.count = count;
+    parallelState.nextIndex = 0;
+    parallelState.body = body;
+    parallelState.state = state;
+
+    // Additional threads (the calling thread is the first worker). If some of them cannot be created, the work is
+    // shared between the ones that could.
+    int extraThreads = 0;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&parallelState.lock);
+    HANDLE* threads = threadCount > 1 ? (HANDLE*)malloc((threadCount - 1) * sizeof(HANDLE)) : NULL;
+
+    if (threads != NULL) {
+        for (int i = 0; i < threadCount - 1; i++) {
+            threads[extraThreads] = CreateThread(NULL, 0, alifilter_parallelForThreadStart, &parallelState, 0, NULL);
+
+            if (threads[extraThreads] != NULL) {
+                extraThreads++;
+            }
+        }
+    }
+
+    alifilter_parallelForWorker(&parallelState);
+
+    for (int i = 0; i < extraThreads; i++) {
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+    }
+
+    free(threads);
+    DeleteCriticalSection(&parallelState.lock);
+#else
+    pthread_mutex_init(&parallelState.lock, NULL);
+    pthread_t* threads = threadCount > 1 ? (pthread_t*)malloc((threadCount - 1) * sizeof(pthread_t)) : NULL;
+
+    if (threads != NULL) {
+        for (int i = 0; i < threadCount - 1; i++) {
+            if (pthread_create(&threads[extraThreads], NULL, alifilter_parallelForThreadStart, &parallelState) == 0) {
+                extraThreads++;
+            }
+        }
+    }
+
+    alifilter_parallelForWorker(&parallelState);
+
+    for (int i = 0; i < extraThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    pthread_mutex_destroy(&parallelState.lock);
+#endif
+}
+
+int alifilter_getProcessorCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+#else
+    long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    return processorCount > 0 ? (int)processorCount : 1;
+#endif
+}
+
+void alifilter_parallelFor(int count, int threadCount, void (*body)(int index, void* state), void* state) {
+    if (threadCount <= 0) {
+        threadCount = alifilter_getProcessorCount();
+    }
+
+    if (threadCount > count) {
+        threadCount = count;
+    }
+
+    // Nothing to share.
+    if (threadCount <= 1) {
+        for (int i = 0; i < count; i++) {
+            body(i, state);
+        }
+
+        return;
+    }
+
+    ALIFILTER_THREADS_LOCK();
+
+    if (alifilter_threads_pool.busy || alifilter_threads_pool.stopping) {
+        ALIFILTER_THREADS_UNLOCK();
+        alifilter_parallelForTemporary(count, threadCount, body, state);
+        return;
+    }
+
+    alifilter_threads_pool.busy = 1;
+
+    // If some of the threads cannot be created, the work is shared between the ones that exist.
+    alifilter_threads_ensureWorkers(threadCount - 1);
+
+    alifilter_threads_job job;
+    job.count = count;
+    job.nextIndex = 0;
+    job.body = body;
+    job.state = state;
+    job.maxHelpers = threadCount - 1;
+    job.helpers = 0;
+    job.activeHelpers = 0;
+
+    alifilter_threads_pool.job = &job;
+    ALIFILTER_THREADS_BROADCAST(alifilter_threads_workAvailable);
+
+    // The calling thread is the first worker.
+    alifilter_threads_runJob(&job);
+
+    while (job.activeHelpers > 0) {
+        ALIFILTER_THREADS_WAIT(alifilter_threads_workFinished);
+    }
+
+    alifilter_threads_pool.job = NULL;
+    alifilter_threads_pool.busy = 0;
+
+    // Wake up alifilter_stopThreadPool, if it is waiting for this call to finish.
+    ALIFILTER_THREADS_BROADCAST(alifilter_threads_workFinished);
+    ALIFILTER_THREADS_UNLOCK();
+}
+
+void alifilter_stopThreadPool(void) {
+    ALIFILTER_THREADS_LOCK();
+
+    // Wait for a running call (or for another alifilter_stopThreadPool call) to finish.
+    while (alifilter_threads_pool.busy || alifilter_threads_pool.stopping) {
+        ALIFILTER_THREADS_WAIT(alifilter_threads_workFinished);
+    }
+
+    alifilter_threads_pool.stopping = 1;
+    ALIFILTER_THREADS_BROADCAST(alifilter_threads_workAvailable);
+
+    int workerCount = alifilter_threads_pool.workerCount;
+    ALIFILTER_THREADS_UNLOCK();
+
+    // New calls use temporary threads while the workers are terminating.
+    for (int i = 0; i < workerCount; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(alifilter_threads_pool.workers[i], INFINITE);
+        CloseHandle(alifilter_threads_pool.workers[i]);
+#else
+        pthread_join(alifilter_threads_pool.workers[i], NULL);
+#endif
+    }
+
+    ALIFILTER_THREADS_LOCK();
+    free(alifilter_threads_pool.workers);
+    alifilter_threads_pool.workers = NULL;
+    alifilter_threads_pool.workerCount = 0;
+    alifilter_threads_pool.workerCapacity = 0;
+    alifilter_threads_pool.stopping = 0;
+    ALIFILTER_THREADS_BROADCAST(alifilter_threads_workFinished);
+    ALIFILTER_THREADS_UNLOCK();
+}
+
+#endif
+#endif
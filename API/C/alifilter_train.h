@@ -0,0 +1,902 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ALIFILTER_TRAIN_H
+#define ALIFILTER_TRAIN_H
+
+// Online training, to update a model when new labelled alignments become available without recomputing the features of
+// the whole training set. The trainer keeps:
+//     • for the linear discriminant analysis, the number of columns, the mean and the scatter matrix of the features in
+//       each class, which are sufficient statistics: merging new columns gives exactly the same result as computing
+//       them on all the columns together;
+//     • for the logistic model, the current coefficients and the accumulated information matrix (the Hessian of the
+//       negative log-likelihood). New columns are folded in by Newton's method (warm-started from the current
+//       coefficients), penalising departures from the current coefficients by the quadratic approximation of the
+//       log-likelihood of the previous data. Each update only reads the new columns; the result is the same as
+//       training on all the columns together up to the error of this (Laplace) approximation, which is small when each
+//       update adds only a part of the data. The first update from an empty trainer is an ordinary maximum-likelihood
+//       fit, like FullModel.Train in the C# library.
+//
+// The trainer state can be saved to a sidecar file, so that it can be updated again later, and the model can be saved
+// as a JSON file in the same format as the models trained by the AliFilter command-line program. The updated model has
+// not been validated, so the thresholds should be re-tuned using the "validate" task of the command-line program (by
+// default, alifilter_parseModel uses a threshold of 0.5).
+//
+// This requires the implementations from alifilter.h and alifilter_mask.h.
+
+#include "alifilter.h"
+#include "alifilter_mask.h"
+
+// Number of parameters of the logistic model (the coefficients followed by the intercept).
+#define ALIFILTER_TRAINER_PARAMETER_COUNT (ALIFILTER_FEATURE_COUNT + 1)
+
+// Signature of the features computed by alifilter_computeAlignmentFeatures (the same as the C# library).
+#define ALIFILTER_FEATURE_SIGNATURE "8D2F81A3625201DA548E08978D516E0C"
+
+// Holds the statistics needed to update a model.
+typedef struct {
+    // Number of columns in each class (0: columns that should be removed, 1: columns that should be preserved).
+    long long classCounts[2];
+
+    // Mean of the features in each class.
+    double classMeans[2][ALIFILTER_FEATURE_COUNT];
+
+    // Scatter matrix of the features in each class (i.e., the sum of the outer products of the differences from the
+    // class mean).
+    double classScatters[2][ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT];
+
+    // Current coefficients of the logistic model, followed by the intercept.
+    double coefficients[ALIFILTER_TRAINER_PARAMETER_COUNT];
+
+    // Information matrix of the logistic model at the current coefficients.
+    double information[ALIFILTER_TRAINER_PARAMETER_COUNT * ALIFILTER_TRAINER_PARAMETER_COUNT];
+
+    // Number of Newton iterations performed by the last update.
+    int iterationCount;
+} alifilter_trainer;
+
+// Initialises an empty trainer.
+void alifilter_initTrainer(alifilter_trainer* out_trainer);
+
+// Updates the trainer with new labelled columns. The logistic model is fitted by Newton's method, halving the steps
+// that would not decrease the penalised negative log-likelihood. If the classes are separable (e.g., when the labels
+// come from another model), the coefficients grow until the likelihood can no longer be improved, and the resulting
+// model reproduces the labels.
+//   Parameters:
+//     • alifilter_trainer* trainer: the trainer.
+//     • const double* features: the features of the new columns (columnCount * ALIFILTER_FEATURE_COUNT elements).
+//     • const char* mask: the label for each column ('1' if the column should be preserved, any other character if it
+//                         should be removed).
+//     • int columnCount: the number of new columns.
+//
+//   Return value:
+//     • 0: success
+//     • 2: the logistic model could not be fitted (because all the columns are in the same class and there are no
+//          previous data, or because the features are not finite); the trainer has not been changed
+int alifilter_updateTrainer(alifilter_trainer* trainer, const double* features, const char* mask, int columnCount);
+
+// Updates the trainer with a labelled alignment.
+//   Parameters:
+//     • alifilter_trainer* trainer: the trainer.
+//     • const char* sequenceData: the alignment sequence data (it should contain sequenceCount * alignmentLength elements).
+//     • int sequenceCount: the number of sequences in the alignment.
+//     • int alignmentLength: the length of each sequence in the alignment.
+//     • const char* mask: the label for each column ('1' if the column should be preserved).
+//
+//   Return value:
+//     • 0: success
+//     • 2: the logistic model could not be fitted (the trainer has not been changed)
+//     • 3: could not allocate enough memory for the alignment features
+int alifilter_addTrainerAlignment(alifilter_trainer* trainer, const char* sequenceData, int sequenceCount, int alignmentLength, const char* mask);
+
+// Gets the current logistic model from the trainer (with a threshold of 0.5).
+void alifilter_getTrainerModel(const alifilter_trainer* trainer, alifilter_model* out_model);
+
+// Saves the trainer state to a file.
+//   Return value: 0 on success, 1 if the file could not be opened, 4 if an error occurred while writing the file, 5 if an
+//   error occurred while closing the file.
+int alifilter_saveTrainer(const char* trainerFile, const alifilter_trainer* trainer);
+
+// Loads the trainer state from a file.
+//   Return value: 0 on success, 1 if the file could not be opened, 2 if the file is not a trainer state file, 4 if an
+//   error occurred while reading the file, 5 if an error occurred while closing the file (but the trainer has been
+//   read successfully).
+int alifilter_loadTrainer(const char* trainerFile, alifilter_trainer* out_trainer);
+
+// Saves the model as a JSON file, with the same structure as the models trained by the AliFilter command-line program.
+//   Parameters:
+//     • const char* modelFile: the path to the output file.
+//     • const alifilter_trainer* trainer: the trainer.
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the linear discriminant analysis could not be computed (e.g., because one of the classes does not have any
+//          columns); the file has not been created
+//     • 4: error while writing the file
+//     • 5: error while closing the file
+int alifilter_saveTrainerModel(const char* modelFile, const alifilter_trainer* trainer);
+
+#ifdef ALIFILTER_TRAIN_IMPLEMENTATION
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Convergence tolerance and maximum number of iterations for the logistic model (the same as FullModel.Train).
+#define ALIFILTER_TRAINER_TOLERANCE 1e-4
+#define ALIFILTER_TRAINER_MAX_ITERATIONS 1000
+
+// Maximum number of times the Newton step is halved when it does not decrease the objective function.
+#define ALIFILTER_TRAINER_MAX_HALVINGS 30
+
+void alifilter_initTrainer(alifilter_trainer* out_trainer) {
+    memset(out_trainer, 0, sizeof(alifilter_trainer));
+}
+
+// Computes the Cholesky decomposition of a symmetric positive definite matrix (in place, lower triangle).
+//   Return value: 0 on success, or 2 if the matrix is not positive definite.
+static int alifilter_trainer_cholesky(double* matrix, int size) {
+    for (int j = 0; j < size; j++) {
+        double diagonal = matrix[j * size + j];
+
+        for (int k = 0; k < j; k++) {
+            diagonal -= matrix[j * size + k] * matrix[j * size + k];
+        }
+
+        if (!(diagonal > 0)) {
+            return 2;
+        }
+
+        matrix[j * size + j] = sqrt(diagonal);
+
+        for (int i = j + 1; i < size; i++) {
+            double value = matrix[i * size + j];
+
+            for (int k = 0; k < j; k++) {
+                value -= matrix[i * size + k] * matrix[j * size + k];
+            }
+
+            matrix[i * size + j] = value / matrix[j * size + j];
+        }
+    }
+
+    return 0;
+}
+
+// Solves L * L^T * x = b in place, where L is the lower triangle computed by alifilter_trainer_cholesky.
+static void alifilter_trainer_choleskySolve(const double* cholesky, int size, double* vector) {
+    for (int i = 0; i < size; i++) {
+        for (int k = 0; k < i; k++) {
+            vector[i] -= cholesky[i * size + k] * vector[k];
+        }
+
+        vector[i] /= cholesky[i * size + i];
+    }
+
+    for (int i = size - 1; i >= 0; i--) {
+        for (int k = i + 1; k < size; k++) {
+            vector[i] -= cholesky[k * size + i] * vector[k];
+        }
+
+        vector[i] /= cholesky[i * size + i];
+    }
+}
+
+// Solves hessian * out_step = gradient. If the Hessian is not (numerically) positive definite, which happens when the
+// classes are separable and the weights of all the columns vanish, an increasing multiple of the identity is added to
+// its diagonal (a ridge), which shortens the step towards the direction of the gradient.
+//   Return value: 0 on success, or 2 if the system could not be solved (e.g., because the Hessian is not finite).
+static int alifilter_trainer_computeStep(const double* hessian, const double* gradient, double* out_step) {
+    double scale = 1;
+
+    for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+        if (!isfinite(hessian[j * ALIFILTER_TRAINER_PARAMETER_COUNT + j]) || !isfinite(gradient[j])) {
+            return 2;
+        }
+
+        scale = MAX(scale, fabs(hessian[j * ALIFILTER_TRAINER_PARAMETER_COUNT + j]));
+    }
+
+    double ridge = 0;
+
+    for (int attempt = 0; attempt < 20; attempt++) {
+        double cholesky[ALIFILTER_TRAINER_PARAMETER_COUNT * ALIFILTER_TRAINER_PARAMETER_COUNT];
+        memcpy(cholesky, hessian, sizeof(cholesky));
+
+        for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+            cholesky[j * ALIFILTER_TRAINER_PARAMETER_COUNT + j] += ridge;
+        }
+
+        if (alifilter_trainer_cholesky(cholesky, ALIFILTER_TRAINER_PARAMETER_COUNT) == 0) {
+            memcpy(out_step, gradient, ALIFILTER_TRAINER_PARAMETER_COUNT * sizeof(double));
+            alifilter_trainer_choleskySolve(cholesky, ALIFILTER_TRAINER_PARAMETER_COUNT, out_step);
+            return 0;
+        }
+
+        ridge = ridge == 0 ? 1e-10 * scale : ridge * 10;
+    }
+
+    return 2;
+}
+
+// Merges the statistics for the new columns in one class into the trainer (Chan et al.'s pairwise update).
+static void alifilter_trainer_updateClass(alifilter_trainer* trainer, int label, const double* features, const char* mask, int columnCount) {
+    long long count = 0;
+    double mean[ALIFILTER_FEATURE_COUNT] = { 0 };
+    double scatter[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT] = { 0 };
+
+    for (int i = 0; i < columnCount; i++) {
+        if ((mask[i] == '1') == label) {
+            count++;
+
+            for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+                mean[j] += features[i * ALIFILTER_FEATURE_COUNT + j];
+            }
+        }
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+        mean[j] /= count;
+    }
+
+    for (int i = 0; i < columnCount; i++) {
+        if ((mask[i] == '1') == label) {
+            for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+                double dj = features[i * ALIFILTER_FEATURE_COUNT + j] - mean[j];
+
+                for (int k = 0; k < ALIFILTER_FEATURE_COUNT; k++) {
+                    scatter[j * ALIFILTER_FEATURE_COUNT + k] += dj * (features[i * ALIFILTER_FEATURE_COUNT + k] - mean[k]);
+                }
+            }
+        }
+    }
+
+    long long previousCount = trainer->classCounts[label];
+    long long totalCount = previousCount + count;
+    double delta[ALIFILTER_FEATURE_COUNT];
+
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+        delta[j] = mean[j] - trainer->classMeans[label][j];
+    }
+
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+        for (int k = 0; k < ALIFILTER_FEATURE_COUNT; k++) {
+            trainer->classScatters[label][j * ALIFILTER_FEATURE_COUNT + k] += scatter[j * ALIFILTER_FEATURE_COUNT + k] + delta[j] * delta[k] * ((double)previousCount * count / totalCount);
+        }
+
+        trainer->classMeans[label][j] += delta[j] * count / totalCount;
+    }
+
+    trainer->classCounts[label] = totalCount;
+}
+
+// Computes the penalised negative log-likelihood of the new columns (the function that is minimised by the update).
+static double alifilter_trainer_computeObjective(const alifilter_trainer* trainer, const double* coefficients, const double* features, const char* mask, int columnCount) {
+    // Penalty: 1/2 (b - b0)^T I0 (b - b0)
+    double objective = 0;
+
+    for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+        for (int k = 0; k < ALIFILTER_TRAINER_PARAMETER_COUNT; k++) {
+            objective += 0.5 * (coefficients[j] - trainer->coefficients[j]) * trainer->information[j * ALIFILTER_TRAINER_PARAMETER_COUNT + k] * (coefficients[k] - trainer->coefficients[k]);
+        }
+    }
+
+    for (int i = 0; i < columnCount; i++) {
+        double projected = coefficients[ALIFILTER_FEATURE_COUNT];
+
+        for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+            projected += coefficients[j] * features[i * ALIFILTER_FEATURE_COUNT + j];
+        }
+
+        // -log(p) for columns that should be preserved, -log(1 - p) for the others, i.e. log(1 + exp(-margin)).
+        double margin = mask[i] == '1' ? projected : -projected;
+        objective += margin > 0 ? log1p(exp(-margin)) : -margin + log1p(exp(margin));
+    }
+
+    return objective;
+}
+
+// Computes the gradient and Hessian of the penalised negative log-likelihood of the new columns.
+static void alifilter_trainer_computeDerivatives(const alifilter_trainer* trainer, const double* coefficients, const double* features, const char* mask, int columnCount, double* out_gradient, double* out_hessian) {
+    // Penalty: 1/2 (b - b0)^T I0 (b - b0)
+    for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+        out_gradient[j] = 0;
+
+        for (int k = 0; k < ALIFILTER_TRAINER_PARAMETER_COUNT; k++) {
+            out_gradient[j] += trainer->information[j * ALIFILTER_TRAINER_PARAMETER_COUNT + k] * (coefficients[k] - trainer->coefficients[k]);
+        }
+    }
+
+    memcpy(out_hessian, trainer->information, sizeof(trainer->information));
+
+    double x[ALIFILTER_TRAINER_PARAMETER_COUNT];
+    x[ALIFILTER_FEATURE_COUNT] = 1;
+
+    for (int i = 0; i < columnCount; i++) {
+        double projected = coefficients[ALIFILTER_FEATURE_COUNT];
+
+        for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+            x[j] = features[i * ALIFILTER_FEATURE_COUNT + j];
+            projected += coefficients[j] * x[j];
+        }
+
+        double p = 1 / (1 + exp(-projected));
+        double residual = p - (mask[i] == '1' ? 1 : 0);
+        double weight = p * (1 - p);
+
+        for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+            out_gradient[j] += residual * x[j];
+
+            for (int k = 0; k <= j; k++) {
+                out_hessian[j * ALIFILTER_TRAINER_PARAMETER_COUNT + k] += weight * x[j] * x[k];
+            }
+        }
+    }
+
+    // Only the lower triangle of the new terms has been computed.
+    for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+        for (int k = j + 1; k < ALIFILTER_TRAINER_PARAMETER_COUNT; k++) {
+            out_hessian[j * ALIFILTER_TRAINER_PARAMETER_COUNT + k] = out_hessian[k * ALIFILTER_TRAINER_PARAMETER_COUNT + j];
+        }
+    }
+}
+
+int alifilter_updateTrainer(alifilter_trainer* trainer, const double* features, const char* mask, int columnCount) {
+    if (columnCount <= 0) {
+        return 0;
+    }
+
+    // Without previous data, the intercept of a model for a single class would be infinite.
+    if (trainer->classCounts[0] + trainer->classCounts[1] == 0) {
+        int preserved = 0;
+
+        for (int i = 0; i < columnCount; i++) {
+            preserved += mask[i] == '1';
+        }
+
+        if (preserved == 0 || preserved == columnCount) {
+            return 2;
+        }
+    }
+
+    // Warm start from the current coefficients.
+    double coefficients[ALIFILTER_TRAINER_PARAMETER_COUNT];
+    double candidate[ALIFILTER_TRAINER_PARAMETER_COUNT];
+    double step[ALIFILTER_TRAINER_PARAMETER_COUNT];
+    double gradient[ALIFILTER_TRAINER_PARAMETER_COUNT];
+    double hessian[ALIFILTER_TRAINER_PARAMETER_COUNT * ALIFILTER_TRAINER_PARAMETER_COUNT];
+
+    memcpy(coefficients, trainer->coefficients, sizeof(coefficients));
+
+    double objective = alifilter_trainer_computeObjective(trainer, coefficients, features, mask, columnCount);
+
+    if (!isfinite(objective)) {
+        return 2;
+    }
+
+    int iterations = 0;
+    int converged = 0;
+
+    while (!converged && iterations < ALIFILTER_TRAINER_MAX_ITERATIONS) {
+        alifilter_trainer_computeDerivatives(trainer, coefficients, features, mask, columnCount, gradient, hessian);
+
+        if (alifilter_trainer_computeStep(hessian, gradient, step) != 0) {
+            break;
+        }
+
+        // Halve the step until the objective function does not increase. If the classes are separable, the
+        // coefficients grow at each step until the weights of all the columns vanish, at which point the ridge
+        // shortens the steps and the iterations converge.
+        double stepSize = 1;
+        double candidateObjective = objective;
+
+        for (int halving = 0; halving <= ALIFILTER_TRAINER_MAX_HALVINGS; halving++) {
+            for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+                candidate[j] = coefficients[j] - stepSize * step[j];
+            }
+
+            candidateObjective = alifilter_trainer_computeObjective(trainer, candidate, features, mask, columnCount);
+
+            if (candidateObjective <= objective) {
+                break;
+            }
+
+            stepSize /= 2;
+        }
+
+        // No step decreases the objective function, so the coefficients are already at the minimum (up to rounding).
+        if (!(candidateObjective <= objective)) {
+            break;
+        }
+
+        converged = 1;
+
+        for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+            if (fabs(stepSize * step[j]) > ALIFILTER_TRAINER_TOLERANCE * MAX(1, fabs(candidate[j]))) {
+                converged = 0;
+            }
+        }
+
+        memcpy(coefficients, candidate, sizeof(coefficients));
+        objective = candidateObjective;
+        iterations++;
+    }
+
+    // The information matrix at the new coefficients.
+    alifilter_trainer_computeDerivatives(trainer, coefficients, features, mask, columnCount, gradient, hessian);
+
+    memcpy(trainer->coefficients, coefficients, sizeof(coefficients));
+    memcpy(trainer->information, hessian, sizeof(hessian));
+    trainer->iterationCount = iterations;
+
+    alifilter_trainer_updateClass(trainer, 0, features, mask, columnCount);
+    alifilter_trainer_updateClass(trainer, 1, features, mask, columnCount);
+
+    return 0;
+}
+
+int alifilter_addTrainerAlignment(alifilter_trainer* trainer, const char* sequenceData, int sequenceCount, int alignmentLength, const char* mask) {
+    double* features = alifilter_getAlignmentFeatures(sequenceData, sequenceCount, alignmentLength);
+
+    if (features == NULL) {
+        return 3;
+    }
+
+    int result = alifilter_updateTrainer(trainer, features, mask, alignmentLength);
+
+    free(features);
+
+    return result;
+}
+
+void alifilter_getTrainerModel(const alifilter_trainer* trainer, alifilter_model* out_model) {
+    out_model->threshold = 0.5;
+
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+        out_model->coefficients[j] = trainer->coefficients[j];
+    }
+
+    out_model->intercept = trainer->coefficients[ALIFILTER_FEATURE_COUNT];
+}
+
+// Number of values (after the header) in a trainer state file.
+#define ALIFILTER_TRAINER_VALUE_COUNT (2 * (1 + ALIFILTER_FEATURE_COUNT + ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT) + ALIFILTER_TRAINER_PARAMETER_COUNT * (1 + ALIFILTER_TRAINER_PARAMETER_COUNT))
+
+// Writes a 64-bit value in little-endian order.
+static int alifilter_trainer_writeUInt64(FILE* fileH, uint64_t value) {
+    unsigned char bytes[8];
+
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+    }
+
+    return fwrite(bytes, 1, 8, fileH) == 8;
+}
+
+// Reads a 64-bit value in little-endian order.
+static uint64_t alifilter_trainer_getUInt64(const unsigned char* source) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)source[i] << (8 * i);
+    }
+
+    return value;
+}
+
+// Reads an array of doubles in little-endian order.
+//   Return value: a pointer to the data after the array.
+static const unsigned char* alifilter_trainer_getDoubles(const unsigned char* source, double* out_values, int count) {
+    for (int i = 0; i < count; i++) {
+        uint64_t bits = alifilter_trainer_getUInt64(source + 8 * i);
+        memcpy(&out_values[i], &bits, sizeof(double));
+    }
+
+    return source + 8 * count;
+}
+
+// Writes an array of doubles in little-endian order.
+static int alifilter_trainer_writeDoubles(FILE* fileH, const double* values, int count) {
+    int ok = 1;
+
+    for (int i = 0; i < count && ok; i++) {
+        uint64_t bits;
+        memcpy(&bits, &values[i], sizeof(double));
+        ok = alifilter_trainer_writeUInt64(fileH, bits);
+    }
+
+    return ok;
+}
+
+int alifilter_saveTrainer(const char* trainerFile, const alifilter_trainer* trainer) {
+    FILE* fileH = fopen(trainerFile, "wb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char header[8] = { 'A', 'F', 'T', 'R', 1, ALIFILTER_FEATURE_COUNT, 0, 0 };
+    int ok = fwrite(header, 1, 8, fileH) == 8;
+
+    for (int c = 0; c < 2 && ok; c++) {
+        ok = alifilter_trainer_writeUInt64(fileH, (uint64_t)trainer->classCounts[c]) &&
+            alifilter_trainer_writeDoubles(fileH, trainer->classMeans[c], ALIFILTER_FEATURE_COUNT) &&
+            alifilter_trainer_writeDoubles(fileH, trainer->classScatters[c], ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT);
+    }
+
+    ok = ok && alifilter_trainer_writeDoubles(fileH, trainer->coefficients, ALIFILTER_TRAINER_PARAMETER_COUNT) &&
+        alifilter_trainer_writeDoubles(fileH, trainer->information, ALIFILTER_TRAINER_PARAMETER_COUNT * ALIFILTER_TRAINER_PARAMETER_COUNT);
+
+    int result = ok ? 0 : 4;
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+int alifilter_loadTrainer(const char* trainerFile, alifilter_trainer* out_trainer) {
+    FILE* fileH = fopen(trainerFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    unsigned char data[8 + 8 * ALIFILTER_TRAINER_VALUE_COUNT];
+    int result = 0;
+
+    if (fread(data, 1, sizeof(data), fileH) != sizeof(data)) {
+        result = ferror(fileH) ? 4 : 2;
+    }
+    else if (memcmp(data, "AFTR", 4) != 0 || data[4] != 1 || data[5] != ALIFILTER_FEATURE_COUNT) {
+        result = 2;
+    }
+    else {
+        alifilter_initTrainer(out_trainer);
+
+        // Read the values in the same order as they were written.
+        const unsigned char* value = data + 8;
+
+        for (int c = 0; c < 2; c++) {
+            out_trainer->classCounts[c] = (long long)alifilter_trainer_getUInt64(value);
+            value += 8;
+            value = alifilter_trainer_getDoubles(value, out_trainer->classMeans[c], ALIFILTER_FEATURE_COUNT);
+            value = alifilter_trainer_getDoubles(value, out_trainer->classScatters[c], ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT);
+        }
+
+        value = alifilter_trainer_getDoubles(value, out_trainer->coefficients, ALIFILTER_TRAINER_PARAMETER_COUNT);
+        alifilter_trainer_getDoubles(value, out_trainer->information, ALIFILTER_TRAINER_PARAMETER_COUNT * ALIFILTER_TRAINER_PARAMETER_COUNT);
+    }
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+// Computes the eigenvalues and eigenvectors of a symmetric matrix using the cyclic Jacobi method. The matrix is
+// overwritten; the eigenvectors are stored in the columns of out_eigenvectors.
+static void alifilter_trainer_jacobi(double* matrix, int size, double* out_eigenvalues, double* out_eigenvectors) {
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            out_eigenvectors[i * size + j] = i == j ? 1 : 0;
+        }
+    }
+
+    for (int sweep = 0; sweep < 100; sweep++) {
+        double offDiagonal = 0;
+        double diagonal = 0;
+
+        for (int i = 0; i < size; i++) {
+            diagonal += matrix[i * size + i] * matrix[i * size + i];
+
+            for (int j = i + 1; j < size; j++) {
+                offDiagonal += matrix[i * size + j] * matrix[i * size + j];
+            }
+        }
+
+        if (offDiagonal <= 1e-30 * diagonal) {
+            break;
+        }
+
+        for (int p = 0; p < size - 1; p++) {
+            for (int q = p + 1; q < size; q++) {
+                double apq = matrix[p * size + q];
+
+                if (apq == 0) {
+                    continue;
+                }
+
+                double theta = (matrix[q * size + q] - matrix[p * size + p]) / (2 * apq);
+                double t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+                double c = 1 / sqrt(t * t + 1);
+                double s = t * c;
+
+                for (int k = 0; k < size; k++) {
+                    double akp = matrix[k * size + p];
+                    double akq = matrix[k * size + q];
+                    matrix[k * size + p] = c * akp - s * akq;
+                    matrix[k * size + q] = s * akp + c * akq;
+                }
+
+                for (int k = 0; k < size; k++) {
+                    double apk = matrix[p * size + k];
+                    double aqk = matrix[q * size + k];
+                    matrix[p * size + k] = c * apk - s * aqk;
+                    matrix[q * size + k] = s * apk + c * aqk;
+                }
+
+                for (int k = 0; k < size; k++) {
+                    double vkp = out_eigenvectors[k * size + p];
+                    double vkq = out_eigenvectors[k * size + q];
+                    out_eigenvectors[k * size + p] = c * vkp - s * vkq;
+                    out_eigenvectors[k * size + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < size; i++) {
+        out_eigenvalues[i] = matrix[i * size + i];
+    }
+}
+
+// The results of the linear discriminant analysis, in the same form as the LdaModel in the C# library.
+typedef struct {
+    double coefficients[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT];
+    double means[2][ALIFILTER_FEATURE_COUNT];
+    double discriminantProportions[ALIFILTER_FEATURE_COUNT];
+    double eigenvalues[ALIFILTER_FEATURE_COUNT];
+    double standardDeviations[ALIFILTER_FEATURE_COUNT];
+} alifilter_trainer_lda;
+
+// Computes the linear discriminant analysis: the generalised eigenvectors of the between-class scatter matrix (the sum
+// of the outer products of the differences between the class means and the overall mean) with respect to the
+// within-class scatter matrix (the sum of the class covariance matrices), sorted by decreasing eigenvalue and scaled so
+// that the largest component of each has an absolute value of 1.
+//   Return value: 0 on success, or 2 if the analysis could not be computed.
+static int alifilter_trainer_computeLDA(const alifilter_trainer* trainer, alifilter_trainer_lda* out_lda) {
+    const int n = ALIFILTER_FEATURE_COUNT;
+    long long totalCount = trainer->classCounts[0] + trainer->classCounts[1];
+
+    if (trainer->classCounts[0] < 1 || trainer->classCounts[1] < 1) {
+        return 2;
+    }
+
+    // Overall mean and standard deviations.
+    double mean[ALIFILTER_FEATURE_COUNT];
+
+    for (int j = 0; j < n; j++) {
+        mean[j] = (trainer->classMeans[0][j] * trainer->classCounts[0] + trainer->classMeans[1][j] * trainer->classCounts[1]) / totalCount;
+    }
+
+    for (int j = 0; j < n; j++) {
+        double sumOfSquares = 0;
+
+        for (int c = 0; c < 2; c++) {
+            double d = trainer->classMeans[c][j] - mean[j];
+            sumOfSquares += trainer->classScatters[c][j * n + j] + trainer->classCounts[c] * d * d;
+        }
+
+        out_lda->standardDeviations[j] = totalCount > 1 ? sqrt(sumOfSquares / (totalCount - 1)) : 0;
+    }
+
+    // Scatter matrices.
+    double within[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT] = { 0 };
+    double between[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT] = { 0 };
+
+    for (int c = 0; c < 2; c++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+                within[j * n + k] += trainer->classScatters[c][j * n + k] / trainer->classCounts[c];
+                between[j * n + k] += (trainer->classMeans[c][j] - mean[j]) * (trainer->classMeans[c][k] - mean[k]);
+            }
+        }
+    }
+
+    // Reduce to a symmetric eigenproblem: C = L^-1 Sb L^-T, where Sw = L L^T.
+    if (alifilter_trainer_cholesky(within, n) != 0) {
+        return 2;
+    }
+
+    double reduced[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT];
+
+    for (int k = 0; k < n; k++) {
+        // Column k of L^-1 Sb.
+        double column[ALIFILTER_FEATURE_COUNT];
+
+        for (int i = 0; i < n; i++) {
+            column[i] = between[i * n + k];
+
+            for (int m = 0; m < i; m++) {
+                column[i] -= within[i * n + m] * column[m];
+            }
+
+            column[i] /= within[i * n + i];
+        }
+
+        for (int i = 0; i < n; i++) {
+            reduced[i * n + k] = column[i];
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        // Row i of (L^-1 Sb) L^-T is the solution of L x = (row i of L^-1 Sb).
+        double row[ALIFILTER_FEATURE_COUNT];
+
+        for (int k = 0; k < n; k++) {
+            row[k] = reduced[i * n + k];
+
+            for (int m = 0; m < k; m++) {
+                row[k] -= within[k * n + m] * row[m];
+            }
+
+            row[k] /= within[k * n + k];
+        }
+
+        for (int k = 0; k < n; k++) {
+            reduced[i * n + k] = row[k];
+        }
+    }
+
+    // Symmetrise to remove rounding errors.
+    for (int i = 0; i < n; i++) {
+        for (int k = i + 1; k < n; k++) {
+            reduced[i * n + k] = reduced[k * n + i] = (reduced[i * n + k] + reduced[k * n + i]) / 2;
+        }
+    }
+
+    double eigenvalues[ALIFILTER_FEATURE_COUNT];
+    double eigenvectors[ALIFILTER_FEATURE_COUNT * ALIFILTER_FEATURE_COUNT];
+    alifilter_trainer_jacobi(reduced, n, eigenvalues, eigenvectors);
+
+    // Back-transform the eigenvectors: v = L^-T w.
+    for (int k = 0; k < n; k++) {
+        for (int i = n - 1; i >= 0; i--) {
+            double value = eigenvectors[i * n + k];
+
+            for (int m = i + 1; m < n; m++) {
+                value -= within[m * n + i] * eigenvectors[m * n + k];
+            }
+
+            eigenvectors[i * n + k] = value / within[i * n + i];
+        }
+    }
+
+    // Sort by decreasing eigenvalue.
+    int order[ALIFILTER_FEATURE_COUNT];
+
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && eigenvalues[order[j]] > eigenvalues[order[j - 1]]; j--) {
+            int swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+
+    double eigenvalueSum = 0;
+
+    for (int k = 0; k < n; k++) {
+        eigenvalueSum += fabs(eigenvalues[k]);
+    }
+
+    for (int k = 0; k < n; k++) {
+        int source = order[k];
+        double maxAbs = 0;
+
+        for (int i = 0; i < n; i++) {
+            maxAbs = MAX(maxAbs, fabs(eigenvectors[i * n + source]));
+        }
+
+        for (int i = 0; i < n; i++) {
+            out_lda->coefficients[i * n + k] = maxAbs > 0 ? eigenvectors[i * n + source] / maxAbs : 0;
+        }
+
+        out_lda->eigenvalues[k] = eigenvalues[source];
+        out_lda->discriminantProportions[k] = eigenvalueSum > 0 ? fabs(eigenvalues[source]) / eigenvalueSum : 0;
+    }
+
+    // Class means in the discriminant space.
+    for (int c = 0; c < 2; c++) {
+        for (int k = 0; k < n; k++) {
+            out_lda->means[c][k] = 0;
+
+            for (int i = 0; i < n; i++) {
+                out_lda->means[c][k] += trainer->classMeans[c][i] * out_lda->coefficients[i * n + k];
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Writes a JSON array of numbers, using the same indentation as the C# library.
+static int alifilter_trainer_writeJSONArray(FILE* fileH, const double* values, int count, const char* indent, const char* terminator) {
+    char buffer[32];
+    int ok = fprintf(fileH, "[\n") > 0;
+
+    for (int i = 0; i < count && ok; i++) {
+        alifilter_formatScore(values[i], buffer);
+        ok = fprintf(fileH, "%s  %s%s\n", indent, buffer, i < count - 1 ? "," : "") > 0;
+    }
+
+    return ok && fprintf(fileH, "%s]%s\n", indent, terminator) > 0;
+}
+
+int alifilter_saveTrainerModel(const char* modelFile, const alifilter_trainer* trainer) {
+    const int n = ALIFILTER_FEATURE_COUNT;
+    alifilter_trainer_lda lda;
+
+    if (alifilter_trainer_computeLDA(trainer, &lda) != 0) {
+        return 2;
+    }
+
+    FILE* fileH = fopen(modelFile, "w");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    char buffer[32];
+
+    int ok = fprintf(fileH, "{\n  \"LdaModel\": {\n    \"Coefficients\": [\n") > 0;
+
+    for (int i = 0; i < n && ok; i++) {
+        ok = fprintf(fileH, "      ") > 0 && alifilter_trainer_writeJSONArray(fileH, &lda.coefficients[i * n], n, "      ", i < n - 1 ? "," : "");
+    }
+
+    ok = ok && fprintf(fileH, "    ],\n    \"Means\": [\n") > 0;
+
+    for (int c = 0; c < 2 && ok; c++) {
+        ok = fprintf(fileH, "      ") > 0 && alifilter_trainer_writeJSONArray(fileH, lda.means[c], n, "      ", c < 1 ? "," : "");
+    }
+
+    ok = ok && fprintf(fileH, "    ],\n    \"DiscriminantProportions\": ") > 0 && alifilter_trainer_writeJSONArray(fileH, lda.discriminantProportions, n, "    ", ",") &&
+        fprintf(fileH, "    \"Eigenvalues\": ") > 0 && alifilter_trainer_writeJSONArray(fileH, lda.eigenvalues, n, "    ", ",") &&
+        fprintf(fileH, "    \"StandardDeviations\": ") > 0 && alifilter_trainer_writeJSONArray(fileH, lda.standardDeviations, n, "    ", "") &&
+        fprintf(fileH, "  },\n  \"LogisticModel\": {\n    \"Coefficients\": ") > 0 && alifilter_trainer_writeJSONArray(fileH, trainer->coefficients, n, "    ", ",");
+
+    if (ok) {
+        alifilter_formatScore(trainer->coefficients[n], buffer);
+        ok = fprintf(fileH, "    \"Intercept\": %s\n  },\n  \"FeatureSignature\": \"%s\"\n}", buffer, ALIFILTER_FEATURE_SIGNATURE) > 0;
+    }
+
+    int result = ok ? 0 : 4;
+
+    if (fclose(fileH) != 0 && result == 0) {
+        result = 5;
+    }
+
+    return result;
+}
+
+#endif
+#endif
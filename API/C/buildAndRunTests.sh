@@ -0,0 +1,3 @@
+#!/bin/bash
+
+gcc -Wall -Wextra -Wpedantic -Werror tests.c -o tests -lz -lm -pthread && ./tests Data $1
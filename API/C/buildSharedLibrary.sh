@@ -0,0 +1,3 @@
+#!/bin/bash
+
+gcc -O3 -Wall -Wextra -Wpedantic -Werror -fPIC -shared alifilter.c -o libalifilter.so -lm
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+gcc -O3 -Wall -Wextra -Wpedantic -Werror sweep.c -o sweep -lz -lm -pthread
@@ -0,0 +1,250 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALIFILTER_FASTA_H
+#define ALIFILTER_FASTA_H
+
+// The alignment struct is shared with the PHYLIP parser.
+#include "phylip.h"
+
+// Parses an alignment file in FASTA format. Sequence names longer than MAX_SEQUENCE_NAME_LENGTH are truncated.
+//   Parameters:
+//     • const char* fastaFile: path to the FASTA file.
+//     • alignment* out_alignment: if the return value is 0 or 5, when this function returns this pointer will point to the parsed alignment
+//                                 (which should be freed using phylip_freeAlignment).
+//
+//   Return value:
+//     • 0: success
+//     • 1: error opening the file
+//     • 2: the file does not contain any sequences
+//     • 3: could not allocate enough memory for the alignment
+//     • 4: error while reading the alignment (e.g., the sequences do not all have the same length)
+//     • 5: error while closing the file (but the alignment has been read successfully and should be freed)
+int fasta_parseFASTA(const char* fastaFile, alignment* out_alignment);
+
+// Parses an alignment file in FASTA or relaxed PHYLIP format, detecting the format from the first character in the file.
+//   Parameters:
+//     • const char* alignmentFile: path to the alignment file.
+//     • alignment* out_alignment: if the return value is 0 or 5, when this function returns this pointer will point to the parsed alignment.
+//
+//   Return value: see fasta_parseFASTA and phylip_parsePHYLIP.
+int fasta_parseAlignment(const char* alignmentFile, alignment* out_alignment);
+
+#ifdef ALIFILTER_FASTA_IMPLEMENTATION
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int fasta_parseFASTA(const char* fastaFile, alignment* out_alignment) {
+
+    // Access the alignment file.
+    FILE* fileH = fopen(fastaFile, "rb");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    // Read the whole file in memory.
+    char* fileData = NULL;
+    size_t fileSize = 0;
+    size_t capacity = 0;
+
+    while (1) {
+        if (fileSize == capacity) {
+            capacity = capacity == 0 ? 1 << 20 : capacity * 2;
+            char* newData = (char*)realloc(fileData, capacity * sizeof(*newData));
+
+            if (newData == NULL) {
+                free(fileData);
+                fclose(fileH);
+                return 3;
+            }
+
+            fileData = newData;
+        }
+
+        size_t readChars = fread(&fileData[fileSize], sizeof(char), capacity - fileSize, fileH);
+
+        if (readChars == 0) {
+            break;
+        }
+
+        fileSize += readChars;
+    }
+
+    if (ferror(fileH)) {
+        free(fileData);
+        fclose(fileH);
+        return 4;
+    }
+
+    // First pass: count the sequences and determine the alignment length.
+    int sequenceCount = 0;
+    long long alignmentLength = -1;
+    long long currLength = 0;
+    int atLineStart = 1;
+    int inHeader = 0;
+
+    for (size_t i = 0; i < fileSize; i++) {
+        char c = fileData[i];
+
+        if (atLineStart && c == '>') {
+            if (sequenceCount > 0) {
+                if (alignmentLength < 0) {
+                    alignmentLength = currLength;
+                }
+                else if (currLength != alignmentLength) {
+                    free(fileData);
+                    fclose(fileH);
+                    return 4;
+                }
+            }
+
+            sequenceCount++;
+            currLength = 0;
+            inHeader = 1;
+        }
+        else if (!inHeader && sequenceCount > 0 && !isspace((unsigned char)c)) {
+            currLength++;
+        }
+
+        if (c == '\n') {
+            inHeader = 0;
+            atLineStart = 1;
+        }
+        else {
+            atLineStart = 0;
+        }
+    }
+
+    if (sequenceCount > 0) {
+        if (alignmentLength < 0) {
+            alignmentLength = currLength;
+        }
+        else if (currLength != alignmentLength) {
+            free(fileData);
+            fclose(fileH);
+            return 4;
+        }
+    }
+
+    if (sequenceCount == 0 || alignmentLength < 1 || alignmentLength > 0x7FFFFFFF) {
+        free(fileData);
+        fclose(fileH);
+        return 2;
+    }
+
+    // Allocate memory for the alignment.
+    char* sequenceNames = (char *)malloc(sequenceCount * (MAX_SEQUENCE_NAME_LENGTH + 1) * sizeof(*sequenceNames));
+    char* sequenceData = (char *)malloc((size_t)sequenceCount * alignmentLength * sizeof(*sequenceData));
+
+    if (sequenceNames == NULL || sequenceData == NULL) {
+        free(sequenceNames);
+        free(sequenceData);
+        free(fileData);
+        fclose(fileH);
+        return 3;
+    }
+
+    // Second pass: copy the sequence names and data.
+    int currSequence = -1;
+    int nameLength = 0;
+    char* currData = sequenceData;
+    atLineStart = 1;
+    inHeader = 0;
+
+    for (size_t i = 0; i < fileSize; i++) {
+        char c = fileData[i];
+
+        if (atLineStart && c == '>') {
+            if (currSequence >= 0) {
+                sequenceNames[currSequence * (MAX_SEQUENCE_NAME_LENGTH + 1) + nameLength] = '\0';
+            }
+
+            currSequence++;
+            nameLength = 0;
+            inHeader = 1;
+        }
+        else if (inHeader) {
+            if (c != '\n' && c != '\r' && nameLength < MAX_SEQUENCE_NAME_LENGTH) {
+                sequenceNames[currSequence * (MAX_SEQUENCE_NAME_LENGTH + 1) + nameLength] = c;
+                nameLength++;
+            }
+        }
+        else if (currSequence >= 0 && !isspace((unsigned char)c)) {
+            *currData = c;
+            currData++;
+        }
+
+        if (c == '\n') {
+            inHeader = 0;
+            atLineStart = 1;
+        }
+        else {
+            atLineStart = 0;
+        }
+    }
+
+    sequenceNames[currSequence * (MAX_SEQUENCE_NAME_LENGTH + 1) + nameLength] = '\0';
+
+    free(fileData);
+
+    out_alignment->sequenceCount = sequenceCount;
+    out_alignment->alignmentLength = (int)alignmentLength;
+    out_alignment->sequenceNames = sequenceNames;
+    out_alignment->sequenceData = sequenceData;
+
+    // Close the file.
+    int result = fclose(fileH);
+
+    if (result != 0) {
+        return 5;
+    }
+    else {
+        return 0;
+    }
+}
+
+int fasta_parseAlignment(const char* alignmentFile, alignment* out_alignment) {
+    // Access the alignment file.
+    FILE* fileH = fopen(alignmentFile, "r");
+    if (fileH == NULL) {
+        return 1;
+    }
+
+    // Find the first character that is not a space.
+    int c = fgetc(fileH);
+    while (c != EOF && isspace(c)) {
+        c = fgetc(fileH);
+    }
+
+    fclose(fileH);
+
+    if (c == '>') {
+        return fasta_parseFASTA(alignmentFile, out_alignment);
+    }
+    else {
+        return phylip_parsePHYLIP(alignmentFile, out_alignment);
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,195 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Command-line driver for the mistake-rate sweep: trains and validates a model for each combination of mistake rate and
+// replicate on the features and labels from a feature file created by the AliFilter command-line program, and prints
+// the results as a tab-separated table.
+//
+// Build with buildSweep.sh (this requires zlib).
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIFILTER_IMPLEMENTATION
+#define ALIFILTER_MASK_IMPLEMENTATION
+#define ALIFILTER_THREADS_IMPLEMENTATION
+#define ALIFILTER_TRAIN_IMPLEMENTATION
+#define ALIFILTER_SWEEP_IMPLEMENTATION
+#include "alifilter_sweep.h"
+
+// Maximum number of mistake rates that can be specified.
+#define SWEEP_MAX_RATES 256
+
+static void printUsage(void) {
+    fprintf(stderr, "\nUsage:\n    sweep <feature file> [options]\n\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "    --validation <feature file>  Validate the models on these features (default: the original labels of the training data).\n");
+    fprintf(stderr, "    --rates <r1,r2,...>          Comma-separated mistake rates, between 0 and 1 (default: 0,0.05,0.1,0.2,0.3,0.4,0.5).\n");
+    fprintf(stderr, "    --replicates <n>             Number of replicates for each mistake rate (default: 10).\n");
+    fprintf(stderr, "    --seed <s>                   Seed for the random number generator (default: 0).\n");
+    fprintf(stderr, "    --threads <t>                Maximum number of threads (default: one per processor).\n\n");
+}
+
+// Parses a comma-separated list of mistake rates. Returns the number of rates, or -1 if the list is not valid.
+static int parseRates(const char* text, double* out_rates) {
+    int count = 0;
+    const char* c = text;
+
+    while (1) {
+        char* end;
+        errno = 0;
+        double rate = strtod(c, &end);
+
+        if (end == c || errno != 0 || !(rate >= 0 && rate <= 1) || count >= SWEEP_MAX_RATES || (*end != ',' && *end != 0)) {
+            return -1;
+        }
+
+        out_rates[count++] = rate;
+
+        if (*end == 0) {
+            return count;
+        }
+
+        c = end + 1;
+    }
+}
+
+// Parses a non-negative integer. Returns 0 on success, 2 if the text is not a valid integer in range.
+static int parseInteger(const char* text, unsigned long long maxValue, unsigned long long* out_value) {
+    char* end;
+    errno = 0;
+
+    if (text[0] < '0' || text[0] > '9') {
+        return 2;
+    }
+
+    unsigned long long value = strtoull(text, &end, 10);
+
+    if (*end != 0 || errno != 0 || value > maxValue) {
+        return 2;
+    }
+
+    *out_value = value;
+    return 0;
+}
+
+// Reads a feature file, printing an error message if something goes wrong. Returns 0 on success.
+static int readFeatures(const char* fileName, alifilter_featureMatrix* out_features) {
+    int error_code = alifilter_readFeatureFile(fileName, out_features);
+
+    if (error_code == 5) {
+        fprintf(stderr, "Warning: error while closing the feature file %s.\n", fileName);
+        error_code = 0;
+    }
+    else if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the feature file %s!\n", error_code, fileName);
+    }
+
+    return error_code;
+}
+
+int main(int argc, char* argv[]) {
+    const char* trainingFile = NULL;
+    const char* validationFile = NULL;
+    double mistakeRates[SWEEP_MAX_RATES] = { 0, 0.05, 0.1, 0.2, 0.3, 0.4, 0.5 };
+    int rateCount = 7;
+    unsigned long long replicateCount = 10;
+    unsigned long long seed = 0;
+    unsigned long long threadCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        int invalid = 0;
+
+        if (strcmp(argv[i], "--validation") == 0 && i + 1 < argc) {
+            validationFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rates") == 0 && i + 1 < argc) {
+            rateCount = parseRates(argv[++i], mistakeRates);
+            invalid = rateCount <= 0;
+        }
+        else if (strcmp(argv[i], "--replicates") == 0 && i + 1 < argc) {
+            invalid = parseInteger(argv[++i], 0x7FFFFFFF, &replicateCount) != 0 || replicateCount == 0;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            invalid = parseInteger(argv[++i], UINT64_MAX, &seed) != 0;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            invalid = parseInteger(argv[++i], 0x7FFFFFFF, &threadCount) != 0;
+        }
+        else if (argv[i][0] != '-' && trainingFile == NULL) {
+            trainingFile = argv[i];
+        }
+        else {
+            invalid = 1;
+        }
+
+        if (invalid) {
+            fprintf(stderr, "\nInvalid argument: %s\n", argv[i]);
+            printUsage();
+            return 64;
+        }
+    }
+
+    if (trainingFile == NULL) {
+        printUsage();
+        return 64;
+    }
+
+    if ((unsigned long long)rateCount * replicateCount > 0x7FFFFFFF) {
+        fprintf(stderr, "\nToo many grid points!\n\n");
+        return 64;
+    }
+
+    alifilter_featureMatrix trainingData;
+    alifilter_featureMatrix validationData;
+
+    if (readFeatures(trainingFile, &trainingData) != 0) {
+        return 1;
+    }
+
+    if (validationFile != NULL && readFeatures(validationFile, &validationData) != 0) {
+        alifilter_freeFeatureMatrix(&trainingData);
+        return 1;
+    }
+
+    int resultCount = rateCount * (int)replicateCount;
+    alifilter_sweepResult* results = (alifilter_sweepResult*)malloc(resultCount * sizeof(alifilter_sweepResult));
+
+    int error_code = results == NULL ? 3 : alifilter_runMistakeSweep(&trainingData, validationFile != NULL ? &validationData : NULL, mistakeRates, rateCount, (int)replicateCount, (uint64_t)seed, (int)threadCount, results);
+
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while running the sweep!\n", error_code);
+    }
+    else if (alifilter_writeSweepResults(stdout, results, resultCount) != 0) {
+        fprintf(stderr, "Error while writing the results!\n");
+        error_code = 4;
+    }
+
+    free(results);
+    if (validationFile != NULL) {
+        alifilter_freeFeatureMatrix(&validationData);
+    }
+    alifilter_freeFeatureMatrix(&trainingData);
+
+    return error_code == 0 ? 0 : 1;
+}
@@ -0,0 +1,1547 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Checks for the optional headers of the C API (alifilter_mask.h, alifilter_pyramid.h, alifilter_bootstrap.h,
+// alifilter_profile.h, alifilter_train.h, alifilter_bgzf.h and alifilter_sweep.h). Each test compares the results of
+// one header with an independent computation (or with files created by the C# library), prints one line for each check
+// ("OK" or "MISMATCH"), and returns 1 if something does not match.
+//
+// Build and run all the tests with buildAndRunTests.sh (this requires zlib), or a single test with e.g.
+// "./buildAndRunTests.sh masks". See example.c for a simpler introduction to the C API.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIFILTER_PHYLIP_IMPLEMENTATION
+#include "phylip.h"
+
+#define ALIFILTER_IMPLEMENTATION
+#include "alifilter.h"
+
+#define ALIFILTER_THREADS_IMPLEMENTATION
+#define ALIFILTER_BOOTSTRAP_IMPLEMENTATION
+#include "alifilter_bootstrap.h"
+
+#define ALIFILTER_MASK_IMPLEMENTATION
+#include "alifilter_mask.h"
+
+#define ALIFILTER_PROFILE_IMPLEMENTATION
+#include "alifilter_profile.h"
+
+#define ALIFILTER_PYRAMID_IMPLEMENTATION
+#include "alifilter_pyramid.h"
+
+#define ALIFILTER_TRAIN_IMPLEMENTATION
+#include "alifilter_train.h"
+
+#define ALIFILTER_BGZF_IMPLEMENTATION
+#include "alifilter_bgzf.h"
+#define ALIFILTER_FASTA_IMPLEMENTATION
+#include "fasta.h"
+
+#define ALIFILTER_SWEEP_IMPLEMENTATION
+#include "alifilter_sweep.h"
+
+// Each test receives the paths to the alignment (argv[1]), the model (argv[2]), the feature file (argv[3]) and the
+// feature file with an incompatible program version (argv[4]) from the data folder.
+
+// Save the column scores in each of the mask formats, read them back and re-threshold them.
+int testMasks(char* argv[]);
+
+// Build a multi-resolution summary (pyramid) of the features and scores, and query it at each level.
+int testPyramid(char* argv[]);
+
+// Accumulate the bootstrap replicates in shards of sequences and blocks of columns, and check that the results are the
+// same as when accumulating the whole alignment.
+int testBootstrapShards(char* argv[]);
+
+// Check that the bootstrap support of columns where all the residues are in the same class (for which the replicates
+// are not computed separately) is the same as when computing each replicate.
+int testBootstrapShortcut(char* argv[]);
+
+// Keep the mask of an alignment up to date while it is being edited, and compare it with the mask computed from scratch
+// after each edit.
+int testProfile(char* argv[]);
+
+// Train a model on the alignment, using the mask from the model file as the labels, and save it.
+int testTrain(char* argv[]);
+
+// Save the filtered alignment as a BGZF file with an index, and read it back.
+int testBGZF(char* argv[]);
+
+// Run a mistake-rate sweep on the alignment, using the mask from the model file as the labels, and check that the
+// results do not depend on the number of threads.
+int testSweep(char* argv[]);
+
+// Read a feature file created by the C# library (two alignments, with bootstrap replicates and a column with a
+// non-finite feature), and compare it with the features computed from the same columns.
+int testFeatureFile(char* argv[]);
+
+// The tests, in the order in which they are run.
+typedef struct {
+    const char* name;
+    int (*run)(char* argv[]);
+} test;
+
+static const test tests[] = {
+    { "masks", testMasks },
+    { "pyramid", testPyramid },
+    { "bootstrap-shards", testBootstrapShards },
+    { "bootstrap-shortcut", testBootstrapShortcut },
+    { "profile", testProfile },
+    { "train", testTrain },
+    { "bgzf", testBGZF },
+    { "sweep", testSweep },
+    { "feature-file", testFeatureFile }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "\nWrong number of arguments!\n    Usage:\n        tests <path to data folder> [<test name>]\n\n");
+        return 64;
+    }
+
+    // Paths to the files in the data folder.
+    const char* fileNames[4] = { "example.phy", "alifilter.validated.json", "example.features.bin", "incompatible.features.bin" };
+    char paths[4][1024];
+    char* testArgs[5];
+    testArgs[0] = argv[0];
+
+    for (int i = 0; i < 4; i++) {
+        if (snprintf(paths[i], sizeof(paths[i]), "%s/%s", argv[1], fileNames[i]) >= (int)sizeof(paths[i])) {
+            fprintf(stderr, "\nThe path to the data folder is too long!\n\n");
+            return 64;
+        }
+
+        testArgs[i + 1] = paths[i];
+    }
+
+    int testCount = sizeof(tests) / sizeof(tests[0]);
+    int run = 0;
+    int failed = 0;
+
+    for (int i = 0; i < testCount; i++) {
+        if (argc == 3 && strcmp(argv[2], tests[i].name) != 0) {
+            continue;
+        }
+
+        fprintf(stdout, "%s:\n", tests[i].name);
+        fflush(stdout);
+
+        if (tests[i].run(testArgs) != 0) {
+            fprintf(stdout, "%s: FAILED\n", tests[i].name);
+            failed++;
+        }
+
+        run++;
+    }
+
+    if (run == 0) {
+        fprintf(stderr, "\nUnknown test %s!\n\n", argv[2]);
+        return 64;
+    }
+
+    fprintf(stdout, "\n%d of %d tests passed.\n", run - failed, run);
+
+    return failed == 0 ? 0 : 1;
+}
+
+int testMasks(char* argv[]) {
+    // Save the column scores in each of the mask formats, read them back and re-threshold them.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    double* alignmentFeatures;
+    double* columnScores;
+    char* mask;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    // Compute the alignment features, the column scores and the mask.
+    alignmentFeatures = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength);
+    if (alignmentFeatures == NULL) {
+        fprintf(stderr, "Error while computing alignment features!\n");
+        return 1;
+    }
+
+    columnScores = alifilter_getScores(model, alignmentFeatures, sequenceAlignment.alignmentLength);
+    if (columnScores == NULL) {
+        fprintf(stderr, "Error while computing column scores!\n");
+        return 1;
+    }
+
+    mask = alifilter_getMaskFromScores(model, columnScores, sequenceAlignment.alignmentLength);
+    if (mask == NULL) {
+        fprintf(stderr, "Error while creating the alignment mask!\n");
+        return 1;
+    }
+
+    // Scores are formatted in the same way as the C# library (the shortest representation that round-trips, with
+    // exponential notation below 0.0001).
+    const double formatValues[] = { 0.5, 0.0001, 0.00001, 1.0 / 3, 1.5e-7, 1e15, 123456789012345.0 };
+    const char* formatExpected[] = { "0.5", "0.0001", "1E-05", "0.3333333333333333", "1.5E-07", "1E+15", "123456789012345" };
+    int mismatches = 0;
+
+    for (int i = 0; i < 7; i++) {
+        char formatted[32];
+        alifilter_formatScore(formatValues[i], formatted);
+
+        if (strcmp(formatted, formatExpected[i]) != 0) {
+            fprintf(stdout, "Score formatted as %s instead of %s\n", formatted, formatExpected[i]);
+            mismatches++;
+        }
+    }
+
+    // Save the mask in each format, read it back, and check that re-thresholding it at the model threshold gives the
+    // same mask. The binary mask and the fuzzy mask lose precision, so for these the scores are only compared with the
+    // ones obtained by saving and reading the file a second time.
+    const int maskTypes[] = { ALIFILTER_MASK_BINARY, ALIFILTER_MASK_FUZZY, ALIFILTER_MASK_FLOAT, ALIFILTER_MASK_SCORES };
+    const char* maskTypeNames[] = { "binary", "fuzzy", "float", "scores" };
+    const char* maskFile = "tests.mask";
+
+    for (int t = 0; t < 4; t++) {
+        double* loadedScores;
+        double* reloadedScores;
+        char* loadedMask;
+        int loadedLength;
+        int reloadedLength;
+        int typeMismatches = 0;
+
+        error_code = alifilter_saveMask(maskFile, maskTypes[t], mask, columnScores, sequenceAlignment.alignmentLength);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while saving the %s mask!\n", error_code, maskTypeNames[t]);
+            return 1;
+        }
+
+        error_code = alifilter_loadMaskScores(maskFile, maskTypes[t], &loadedScores, &loadedLength);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while reading the %s mask!\n", error_code, maskTypeNames[t]);
+            return 1;
+        }
+
+        error_code = alifilter_rethresholdMask(maskFile, maskTypes[t], maskTypes[t] == ALIFILTER_MASK_BINARY ? 0.5 : model.threshold, &loadedMask);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while re-thresholding the %s mask!\n", error_code, maskTypeNames[t]);
+            return 1;
+        }
+
+        // Save the scores that have been read and read them again.
+        error_code = alifilter_saveMask(maskFile, maskTypes[t], loadedMask, loadedScores, loadedLength);
+        if (error_code == 0) {
+            error_code = alifilter_loadMaskScores(maskFile, maskTypes[t], &reloadedScores, &reloadedLength);
+        }
+
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while saving the %s mask again!\n", error_code, maskTypeNames[t]);
+            return 1;
+        }
+
+        int lossless = maskTypes[t] == ALIFILTER_MASK_FLOAT || maskTypes[t] == ALIFILTER_MASK_SCORES;
+
+        if (loadedLength != sequenceAlignment.alignmentLength || reloadedLength != loadedLength) {
+            typeMismatches++;
+        }
+        else {
+            for (int i = 0; i < loadedLength; i++) {
+                if ((lossless && loadedScores[i] != columnScores[i]) || reloadedScores[i] != loadedScores[i]) {
+                    typeMismatches++;
+                }
+            }
+
+            // The fuzzy mask is not precise enough to re-threshold at an arbitrary value.
+            if (maskTypes[t] != ALIFILTER_MASK_FUZZY && strcmp(loadedMask, mask) != 0) {
+                typeMismatches++;
+            }
+        }
+
+        fprintf(stdout, "%s mask: %s\n", maskTypeNames[t], typeMismatches == 0 ? "OK" : "MISMATCH");
+        mismatches += typeMismatches;
+
+        free(reloadedScores);
+        free(loadedMask);
+        free(loadedScores);
+    }
+
+    remove(maskFile);
+
+    // Free memory
+    free(mask);
+    free(columnScores);
+    free(alignmentFeatures);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+int testPyramid(char* argv[]) {
+    // Build a multi-resolution summary (pyramid) of the features and scores, and query it at each level.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    alifilter_pyramid pyramid;
+    double* alignmentFeatures;
+    double* columnScores;
+    char* mask;
+    float* binStats;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    // Compute the alignment features, the column scores and the mask.
+    alignmentFeatures = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength);
+    if (alignmentFeatures == NULL) {
+        fprintf(stderr, "Error while computing alignment features!\n");
+        return 1;
+    }
+
+    columnScores = alifilter_getScores(model, alignmentFeatures, sequenceAlignment.alignmentLength);
+    if (columnScores == NULL) {
+        fprintf(stderr, "Error while computing column scores!\n");
+        return 1;
+    }
+
+    mask = alifilter_getMaskFromScores(model, columnScores, sequenceAlignment.alignmentLength);
+    if (mask == NULL) {
+        fprintf(stderr, "Error while creating the alignment mask!\n");
+        return 1;
+    }
+
+    // Save the pyramid and open it.
+    const char* pyramidFile = "tests.pyramid";
+
+    error_code = alifilter_savePyramid(pyramidFile, alignmentFeatures, columnScores, mask, sequenceAlignment.alignmentLength);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while saving the pyramid!\n", error_code);
+        return 1;
+    }
+
+    error_code = alifilter_openPyramid(pyramidFile, &pyramid);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while opening the pyramid!\n", error_code);
+        return 1;
+    }
+
+    binStats = (float*)malloc((size_t)sequenceAlignment.alignmentLength * ALIFILTER_PYRAMID_TRACK_COUNT * 3 * sizeof(float));
+    if (binStats == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    // Read each level in full, and compare each bin with the statistics computed directly from the columns it covers.
+    // The minimum and maximum must match exactly, while the mean may differ in the last digit (as the sums are
+    // accumulated in a different order).
+    int mismatches = 0;
+
+    for (int level = 0; level < pyramid.levelCount; level++) {
+        long long binSize = alifilter_getPyramidBinSize(&pyramid, level);
+        long long binCount = alifilter_getPyramidBinCount(&pyramid, level);
+        int levelMismatches = 0;
+
+        if (alifilter_queryPyramid(&pyramid, level, 0, (int)binCount, binStats) != binCount) {
+            levelMismatches++;
+        }
+        else {
+            for (long long bin = 0; bin < binCount; bin++) {
+                int firstColumn = (int)(bin * binSize);
+                int lastColumn = (int)MIN((bin + 1) * binSize, sequenceAlignment.alignmentLength);
+
+                for (int track = 0; track < ALIFILTER_PYRAMID_TRACK_COUNT; track++) {
+                    double minimum = INFINITY;
+                    double sum = 0;
+                    double maximum = -INFINITY;
+
+                    for (int i = firstColumn; i < lastColumn; i++) {
+                        double value;
+
+                        if (track < ALIFILTER_FEATURE_COUNT) {
+                            value = alignmentFeatures[i * ALIFILTER_FEATURE_COUNT + track];
+                        }
+                        else if (track == ALIFILTER_PYRAMID_SCORE_TRACK) {
+                            value = columnScores[i];
+                        }
+                        else {
+                            value = mask[i] == '1' ? 1 : 0;
+                        }
+
+                        minimum = MIN(minimum, value);
+                        sum += value;
+                        maximum = MAX(maximum, value);
+                    }
+
+                    const float* stats = binStats + (bin * ALIFILTER_PYRAMID_TRACK_COUNT + track) * 3;
+                    double mean = sum / (lastColumn - firstColumn);
+
+                    if (stats[0] != (float)minimum || stats[2] != (float)maximum || fabs(stats[1] - mean) > 1e-6 * MAX(1, fabs(mean))) {
+                        levelMismatches++;
+                    }
+                }
+            }
+        }
+
+        fprintf(stdout, "Level %d (%lld bin(s), %lld column(s) per bin): %s\n", level, binCount, binSize, levelMismatches == 0 ? "OK" : "MISMATCH");
+        mismatches += levelMismatches;
+    }
+
+    // Select the level to draw the whole alignment on a plot that is 100 pixels wide.
+    int plotLevel = alifilter_selectPyramidLevel(&pyramid, 0, sequenceAlignment.alignmentLength, 100);
+    fprintf(stdout, "Level for a 100-pixel plot: %d (%lld bins)\n", plotLevel, alifilter_getPyramidBinCount(&pyramid, plotLevel));
+
+    if (alifilter_getPyramidBinCount(&pyramid, plotLevel) > 100 || (plotLevel > 0 && alifilter_getPyramidBinCount(&pyramid, plotLevel - 1) <= 100)) {
+        mismatches++;
+    }
+
+    alifilter_closePyramid(&pyramid);
+    remove(pyramidFile);
+
+    // Free memory
+    free(binStats);
+    free(mask);
+    free(columnScores);
+    free(alignmentFeatures);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Accumulates all the sequences of an alignment for the specified columns and, if out_mask is not NULL, computes the
+// bootstrap mask (used by the bootstrap tests).
+int computeBootstrapMask(alignment sequenceAlignment, alifilter_model model, double bootstrapThreshold, int replicateCount, int firstColumn, int columnCount, alifilter_bootstrap* out_bootstrap, double* out_support, char* out_mask) {
+    int error_code = alifilter_initBootstrap(out_bootstrap, sequenceAlignment.alignmentLength, firstColumn, columnCount, replicateCount, 42);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while initialising the bootstrap replicates!\n", error_code);
+        return 1;
+    }
+
+    for (int i = 0; i < sequenceAlignment.sequenceCount; i += 64) {
+        int blockSize = MIN(64, sequenceAlignment.sequenceCount - i);
+
+        error_code = alifilter_addBootstrapSequences(out_bootstrap, &sequenceAlignment.sequenceData[i * sequenceAlignment.alignmentLength], blockSize, i);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while computing the bootstrap replicates!\n", error_code);
+            return 1;
+        }
+    }
+
+    if (out_mask != NULL) {
+        alifilter_computeBootstrapMask(out_bootstrap, model, bootstrapThreshold, 0, out_support, out_mask);
+    }
+
+    return 0;
+}
+
+int testBootstrapShards(char* argv[]) {
+    // Accumulate the bootstrap replicates in shards of sequences and blocks of columns, and check that the
+    // results are the same as when accumulating the whole alignment.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alignment duplicatedAlignment;
+    alifilter_model model;
+    alifilter_bootstrap bootstrap;
+    alifilter_bootstrap shards[3];
+    double bootstrapThreshold;
+    int replicateCount;
+    double* alignmentFeatures;
+    double* bootstrapFeatures;
+    double* support;
+    double* otherSupport;
+    char* mask;
+    char* otherMask;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file and the accurate mode settings.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    error_code = alifilter_parseAccurateSettings(argv[2], &model.threshold, &bootstrapThreshold, &replicateCount);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the accurate mode settings!\n", error_code);
+        return 1;
+    }
+
+    // The results are compared exactly, so fewer replicates than in the accurate mode settings are enough.
+    replicateCount = MIN(replicateCount, 100);
+
+    int alignmentLength = sequenceAlignment.alignmentLength;
+
+    alignmentFeatures = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, alignmentLength);
+    bootstrapFeatures = (double*)malloc((size_t)alignmentLength * ALIFILTER_FEATURE_COUNT * sizeof(double));
+    support = (double*)malloc(alignmentLength * sizeof(double));
+    otherSupport = (double*)malloc(alignmentLength * sizeof(double));
+    mask = (char*)malloc(alignmentLength * sizeof(char));
+    otherMask = (char*)malloc(alignmentLength * sizeof(char));
+
+    if (alignmentFeatures == NULL || bootstrapFeatures == NULL || support == NULL || otherSupport == NULL || mask == NULL || otherMask == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    // Accumulate the whole alignment at once.
+    if (computeBootstrapMask(sequenceAlignment, model, bootstrapThreshold, replicateCount, 0, alignmentLength, &bootstrap, support, mask) != 0) {
+        return 1;
+    }
+
+    // Replicate 0 is the original alignment: its features must be the same as the ones computed directly.
+    int mismatches = 0;
+
+    alifilter_computeBootstrapFeatures(&bootstrap, 0, bootstrapFeatures);
+    int replicate0Mismatches = memcmp(bootstrapFeatures, alignmentFeatures, (size_t)alignmentLength * ALIFILTER_FEATURE_COUNT * sizeof(double)) != 0;
+    fprintf(stdout, "Replicate 0 features: %s\n", replicate0Mismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += replicate0Mismatches;
+
+    // Each sequence appearing twice does not change the proportions of the residues in each column, so the features of
+    // replicate 0 must be the same (up to rounding) as the features of the original alignment.
+    duplicatedAlignment = sequenceAlignment;
+    duplicatedAlignment.sequenceCount = 2 * sequenceAlignment.sequenceCount;
+    duplicatedAlignment.sequenceData = (char*)malloc((size_t)duplicatedAlignment.sequenceCount * alignmentLength * sizeof(char));
+
+    if (duplicatedAlignment.sequenceData == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    memcpy(duplicatedAlignment.sequenceData, sequenceAlignment.sequenceData, (size_t)sequenceAlignment.sequenceCount * alignmentLength);
+    memcpy(duplicatedAlignment.sequenceData + (size_t)sequenceAlignment.sequenceCount * alignmentLength, sequenceAlignment.sequenceData, (size_t)sequenceAlignment.sequenceCount * alignmentLength);
+
+    alifilter_bootstrap duplicatedBootstrap;
+    if (computeBootstrapMask(duplicatedAlignment, model, bootstrapThreshold, replicateCount, 0, alignmentLength, &duplicatedBootstrap, NULL, NULL) != 0) {
+        return 1;
+    }
+
+    alifilter_computeBootstrapFeatures(&duplicatedBootstrap, 0, bootstrapFeatures);
+    int duplicatedMismatches = 0;
+
+    for (int i = 0; i < alignmentLength * ALIFILTER_FEATURE_COUNT; i++) {
+        if (fabs(bootstrapFeatures[i] - alignmentFeatures[i]) > 1e-12) {
+            duplicatedMismatches++;
+        }
+    }
+
+    fprintf(stdout, "Replicate 0 features with duplicated sequences: %s\n", duplicatedMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += duplicatedMismatches;
+    alifilter_freeBootstrap(&duplicatedBootstrap);
+    free(duplicatedAlignment.sequenceData);
+
+    // Split the sequences into three shards (blocks of 16 sequences are assigned to the shards in turn), adding the
+    // blocks in reverse order. The second shard is saved to a file and read back (e.g., to merge it on a different
+    // machine), then all the shards are merged into the first one.
+    for (int s = 0; s < 3; s++) {
+        error_code = alifilter_initBootstrap(&shards[s], alignmentLength, 0, alignmentLength, replicateCount, 42);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while initialising the bootstrap replicates!\n", error_code);
+            return 1;
+        }
+    }
+
+    for (int i = ((sequenceAlignment.sequenceCount - 1) / 16) * 16; i >= 0; i -= 16) {
+        int blockSize = MIN(16, sequenceAlignment.sequenceCount - i);
+
+        error_code = alifilter_addBootstrapSequences(&shards[(i / 16) % 3], &sequenceAlignment.sequenceData[i * alignmentLength], blockSize, i);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while computing the bootstrap replicates!\n", error_code);
+            return 1;
+        }
+    }
+
+    const char* bootstrapFile = "tests.bootstrap";
+
+    error_code = alifilter_saveBootstrap(bootstrapFile, &shards[1]);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while saving the bootstrap replicates!\n", error_code);
+        return 1;
+    }
+
+    alifilter_freeBootstrap(&shards[1]);
+
+    error_code = alifilter_loadBootstrap(bootstrapFile, &shards[1]);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the bootstrap replicates!\n", error_code);
+        return 1;
+    }
+
+    remove(bootstrapFile);
+
+    for (int s = 1; s < 3; s++) {
+        error_code = alifilter_mergeBootstrap(&shards[0], &shards[s]);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while merging the bootstrap replicates!\n", error_code);
+            return 1;
+        }
+
+        alifilter_freeBootstrap(&shards[s]);
+    }
+
+    alifilter_computeBootstrapMask(&shards[0], model, bootstrapThreshold, 0, otherSupport, otherMask);
+
+    int shardMismatches = shards[0].sequenceCount != bootstrap.sequenceCount || memcmp(otherSupport, support, alignmentLength * sizeof(double)) != 0 || memcmp(otherMask, mask, alignmentLength) != 0;
+    fprintf(stdout, "Merged shards: %s\n", shardMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += shardMismatches;
+    alifilter_freeBootstrap(&shards[0]);
+
+    // Compute the mask in blocks of 1000 columns (e.g., to limit the size of the count tables).
+    int blockMismatches = 0;
+
+    for (int firstColumn = 0; firstColumn < alignmentLength; firstColumn += 1000) {
+        int columnCount = MIN(1000, alignmentLength - firstColumn);
+        alifilter_bootstrap blockBootstrap;
+
+        if (computeBootstrapMask(sequenceAlignment, model, bootstrapThreshold, replicateCount, firstColumn, columnCount, &blockBootstrap, otherSupport + firstColumn, otherMask + firstColumn) != 0) {
+            return 1;
+        }
+
+        alifilter_freeBootstrap(&blockBootstrap);
+    }
+
+    blockMismatches = memcmp(otherSupport, support, alignmentLength * sizeof(double)) != 0 || memcmp(otherMask, mask, alignmentLength) != 0;
+    fprintf(stdout, "Column blocks: %s\n", blockMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += blockMismatches;
+
+    // Free memory
+    free(otherMask);
+    free(mask);
+    free(otherSupport);
+    free(support);
+    free(bootstrapFeatures);
+    free(alignmentFeatures);
+    alifilter_freeBootstrap(&bootstrap);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+int testBootstrapShortcut(char* argv[]) {
+    // Check that the bootstrap support of columns where all the residues are in the same class (for which the
+    // replicates are not computed separately) is the same as when computing each replicate.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    alifilter_bootstrap bootstrap;
+    double bootstrapThreshold;
+    int replicateCount;
+    double* replicateFeatures;
+    double* replicateScores;
+    double* support;
+    int* preservedCounts;
+    char* mask;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file and the accurate mode settings.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    error_code = alifilter_parseAccurateSettings(argv[2], &model.threshold, &bootstrapThreshold, &replicateCount);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the accurate mode settings!\n", error_code);
+        return 1;
+    }
+
+    // The results are compared exactly, so fewer replicates than in the accurate mode settings are enough.
+    replicateCount = MIN(replicateCount, 100);
+
+    int alignmentLength = sequenceAlignment.alignmentLength;
+
+    // Make some of the columns invariant by copying the residue of the first sequence to all the other sequences:
+    // isolated runs of 3 columns (whose neighbours are not invariant) and runs of 10 columns (whose neighbours are
+    // invariant as well, except at the ends).
+    for (int j = 0; j < alignmentLength; j++) {
+        if (j % 7 < 3 || j % 50 < 10) {
+            for (int i = 1; i < sequenceAlignment.sequenceCount; i++) {
+                sequenceAlignment.sequenceData[i * alignmentLength + j] = sequenceAlignment.sequenceData[j];
+            }
+        }
+    }
+
+    replicateFeatures = (double*)malloc((size_t)alignmentLength * ALIFILTER_FEATURE_COUNT * sizeof(double));
+    replicateScores = (double*)malloc(alignmentLength * sizeof(double));
+    support = (double*)malloc(alignmentLength * sizeof(double));
+    preservedCounts = (int*)calloc(alignmentLength, sizeof(int));
+    mask = (char*)malloc(alignmentLength * sizeof(char));
+
+    if (replicateFeatures == NULL || replicateScores == NULL || support == NULL || preservedCounts == NULL || mask == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    if (computeBootstrapMask(sequenceAlignment, model, bootstrapThreshold, replicateCount, 0, alignmentLength, &bootstrap, support, mask) != 0) {
+        return 1;
+    }
+
+    // Compute the features and the scores of every column in each replicate, and count the replicates in which each
+    // column is preserved.
+    for (int r = 1; r <= replicateCount; r++) {
+        alifilter_computeBootstrapFeatures(&bootstrap, r, replicateFeatures);
+        alifilter_computeScores(model, replicateFeatures, alignmentLength, replicateScores);
+
+        for (int j = 0; j < alignmentLength; j++) {
+            preservedCounts[j] += replicateScores[j] >= model.threshold;
+        }
+    }
+
+    int invariantMismatches = 0;
+    int otherMismatches = 0;
+
+    for (int j = 0; j < alignmentLength; j++) {
+        if (support[j] != (double)preservedCounts[j] / replicateCount) {
+            if (j % 7 < 3 || j % 50 < 10) {
+                invariantMismatches++;
+            }
+            else {
+                otherMismatches++;
+            }
+        }
+    }
+
+    fprintf(stdout, "Invariant columns: %s\n", invariantMismatches == 0 ? "OK" : "MISMATCH");
+    fprintf(stdout, "Other columns: %s\n", otherMismatches == 0 ? "OK" : "MISMATCH");
+
+    // Free memory
+    free(mask);
+    free(preservedCounts);
+    free(support);
+    free(replicateScores);
+    free(replicateFeatures);
+    alifilter_freeBootstrap(&bootstrap);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return invariantMismatches + otherMismatches == 0 ? 0 : 1;
+}
+
+int testProfile(char* argv[]) {
+    // Keep the mask of an alignment up to date while it is being edited, and compare it with the mask computed
+    // from scratch after each edit.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    alifilter_profile profile;
+    double* alignmentFeatures;
+    double* columnScores;
+    char* mask;
+    char* previousMask;
+    char* columnData;
+    char* currentData;
+    char* editedData;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    // Create the profile.
+    error_code = alifilter_createProfile(model, sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength, &profile);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while creating the profile!\n", error_code);
+        return 1;
+    }
+
+    // Each edit removes and inserts at most this many columns.
+    const int maxEditSize = 50;
+    const int editCount = 50;
+    int sequenceCount = sequenceAlignment.sequenceCount;
+    int originalLength = sequenceAlignment.alignmentLength;
+    int maxLength = originalLength + editCount * maxEditSize;
+
+    alignmentFeatures = (double*)malloc((size_t)maxLength * ALIFILTER_FEATURE_COUNT * sizeof(double));
+    columnScores = (double*)malloc(maxLength * sizeof(double));
+    mask = (char*)malloc(maxLength * sizeof(char));
+    previousMask = (char*)malloc(maxLength * sizeof(char));
+    columnData = (char*)malloc((size_t)sequenceCount * maxEditSize * sizeof(char));
+    currentData = (char*)malloc((size_t)sequenceCount * maxLength * sizeof(char));
+    editedData = (char*)malloc((size_t)sequenceCount * maxLength * sizeof(char));
+
+    if (alignmentFeatures == NULL || columnScores == NULL || mask == NULL || previousMask == NULL || columnData == NULL || currentData == NULL || editedData == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    // The edits are applied to a copy of the sequences (the original alignment is used as a source of new columns).
+    memcpy(currentData, sequenceAlignment.sequenceData, (size_t)sequenceCount * originalLength);
+
+    int mismatches = 0;
+    srand(42);
+
+    for (int edit = 0; edit < editCount; edit++) {
+        int alignmentLength = profile.alignmentLength;
+
+        // Choose a random edit (which must leave at least one column), and copy random columns of the original
+        // alignment as the new columns.
+        int firstColumn = rand() % (alignmentLength + 1);
+        int removedColumnCount = rand() % (MIN(maxEditSize, alignmentLength - firstColumn) + 1);
+        int insertedColumnCount = rand() % (maxEditSize + 1);
+
+        if (removedColumnCount == alignmentLength && insertedColumnCount == 0) {
+            insertedColumnCount = 1;
+        }
+
+        for (int j = 0; j < insertedColumnCount; j++) {
+            int sourceColumn = rand() % originalLength;
+
+            for (int i = 0; i < sequenceCount; i++) {
+                columnData[i * insertedColumnCount + j] = sequenceAlignment.sequenceData[i * originalLength + sourceColumn];
+            }
+        }
+
+        // Apply the edit to the profile.
+        int* changedColumns;
+        int changedColumnCount;
+
+        memcpy(previousMask, profile.mask, alignmentLength);
+
+        error_code = alifilter_replaceProfileColumns(&profile, firstColumn, removedColumnCount, columnData, insertedColumnCount, &changedColumns, &changedColumnCount);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while editing the profile!\n", error_code);
+            return 1;
+        }
+
+        // Apply the same edit to the sequences.
+        int newLength = alignmentLength - removedColumnCount + insertedColumnCount;
+
+        for (int i = 0; i < sequenceCount; i++) {
+            const char* sequence = currentData + (size_t)i * alignmentLength;
+            char* newSequence = editedData + (size_t)i * newLength;
+
+            memcpy(newSequence, sequence, firstColumn);
+            memcpy(newSequence + firstColumn, columnData + (size_t)i * insertedColumnCount, insertedColumnCount);
+            memcpy(newSequence + firstColumn + insertedColumnCount, sequence + firstColumn + removedColumnCount, alignmentLength - firstColumn - removedColumnCount);
+        }
+
+        char* swap = currentData;
+        currentData = editedData;
+        editedData = swap;
+
+        // Compute the features, scores and mask from scratch.
+        alifilter_computeAlignmentFeatures(currentData, sequenceCount, newLength, alignmentFeatures);
+        alifilter_computeScores(model, alignmentFeatures, newLength, columnScores);
+        alifilter_computeMaskFromScores(model, columnScores, newLength, mask);
+
+        int editMismatches = profile.alignmentLength != newLength;
+
+        for (int j = 0; j < newLength && editMismatches == 0; j++) {
+            for (int k = 0; k < ALIFILTER_FEATURE_COUNT; k++) {
+                if (fabs(profile.features[j * ALIFILTER_FEATURE_COUNT + k] - alignmentFeatures[j * ALIFILTER_FEATURE_COUNT + k]) > 1e-9) {
+                    editMismatches++;
+                }
+            }
+
+            if (fabs(profile.scores[j] - columnScores[j]) > 1e-9 || profile.mask[j] != mask[j]) {
+                editMismatches++;
+            }
+        }
+
+        // The changed columns should be the inserted columns, followed by all the other columns whose mask value has
+        // changed (in any order).
+        int expectedChangedCount = insertedColumnCount;
+
+        for (int j = 0; j < newLength && editMismatches == 0; j++) {
+            if (j >= firstColumn && j < firstColumn + insertedColumnCount) {
+                editMismatches += changedColumns[j - firstColumn] != j;
+            }
+            else {
+                int previousColumn = j < firstColumn ? j : j - insertedColumnCount + removedColumnCount;
+
+                if (previousMask[previousColumn] != mask[j]) {
+                    int found = 0;
+
+                    for (int c = insertedColumnCount; c < changedColumnCount && !found; c++) {
+                        found = changedColumns[c] == j;
+                    }
+
+                    editMismatches += !found;
+                    expectedChangedCount++;
+                }
+            }
+        }
+
+        editMismatches += editMismatches == 0 && changedColumnCount != expectedChangedCount;
+        mismatches += editMismatches;
+
+        free(changedColumns);
+    }
+
+    fprintf(stdout, "%d random edits (final length %d): %s\n", editCount, profile.alignmentLength, mismatches == 0 ? "OK" : "MISMATCH");
+
+    // Free memory
+    free(editedData);
+    free(currentData);
+    free(columnData);
+    free(previousMask);
+    free(mask);
+    free(columnScores);
+    free(alignmentFeatures);
+    alifilter_freeProfile(&profile);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+int testTrain(char* argv[]) {
+    // Train a model on the alignment, using the mask from the model file as the labels, and save it.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    alifilter_model trainedModel;
+    alifilter_model savedModel;
+    alifilter_trainer trainer;
+    alifilter_trainer halvesTrainer;
+    alifilter_trainer loadedTrainer;
+    double* alignmentFeatures;
+    double* columnScores;
+    char* labels;
+    char* mask;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    int alignmentLength = sequenceAlignment.alignmentLength;
+
+    // Compute the alignment features and use the mask as the labels.
+    alignmentFeatures = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, alignmentLength);
+    if (alignmentFeatures == NULL) {
+        fprintf(stderr, "Error while computing alignment features!\n");
+        return 1;
+    }
+
+    labels = alifilter_getMaskFromFeatures(model, alignmentFeatures, alignmentLength);
+    columnScores = (double*)malloc(alignmentLength * sizeof(double));
+    mask = (char*)malloc(alignmentLength * sizeof(char));
+
+    if (labels == NULL || columnScores == NULL || mask == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    // These labels are separable (they come from a logistic model), so the trained model should reproduce them.
+    int mismatches = 0;
+
+    alifilter_initTrainer(&trainer);
+    error_code = alifilter_updateTrainer(&trainer, alignmentFeatures, labels, alignmentLength);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while training the model!\n", error_code);
+        return 1;
+    }
+
+    alifilter_getTrainerModel(&trainer, &trainedModel);
+    alifilter_computeScores(trainedModel, alignmentFeatures, alignmentLength, columnScores);
+    alifilter_computeMaskFromScores(trainedModel, columnScores, alignmentLength, mask);
+
+    int separableMismatches = memcmp(mask, labels, alignmentLength) != 0;
+    fprintf(stdout, "Separable labels (%d iterations): %s\n", trainer.iterationCount, separableMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += separableMismatches;
+
+    // Change one label in ten, then train a model on all the columns at once, and another one by adding the two halves
+    // of the alignment one after the other. The coefficients should be close (but not identical, as the information
+    // from the first half is approximated).
+    for (int i = 0; i < alignmentLength; i += 10) {
+        labels[i] = labels[i] == '1' ? '0' : '1';
+    }
+
+    alifilter_initTrainer(&trainer);
+    alifilter_initTrainer(&halvesTrainer);
+
+    int halfLength = alignmentLength / 2;
+
+    error_code = alifilter_updateTrainer(&trainer, alignmentFeatures, labels, alignmentLength);
+    if (error_code == 0) {
+        error_code = alifilter_updateTrainer(&halvesTrainer, alignmentFeatures, labels, halfLength);
+    }
+    if (error_code == 0) {
+        error_code = alifilter_updateTrainer(&halvesTrainer, alignmentFeatures + halfLength * ALIFILTER_FEATURE_COUNT, labels + halfLength, alignmentLength - halfLength);
+    }
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while training the model!\n", error_code);
+        return 1;
+    }
+
+    double maxDifference = 0;
+
+    for (int j = 0; j < ALIFILTER_TRAINER_PARAMETER_COUNT; j++) {
+        maxDifference = MAX(maxDifference, fabs(trainer.coefficients[j] - halvesTrainer.coefficients[j]) / MAX(1, fabs(trainer.coefficients[j])));
+    }
+
+    int halvesMismatches = maxDifference > 0.05 || halvesTrainer.classCounts[0] != trainer.classCounts[0] || halvesTrainer.classCounts[1] != trainer.classCounts[1];
+    fprintf(stdout, "Noisy labels, in two halves: %s\n", halvesMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += halvesMismatches;
+
+    // Save the trainer state and read it back.
+    const char* trainerFile = "tests.trainer";
+
+    error_code = alifilter_saveTrainer(trainerFile, &halvesTrainer);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while saving the trainer!\n", error_code);
+        return 1;
+    }
+
+    error_code = alifilter_loadTrainer(trainerFile, &loadedTrainer);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the trainer!\n", error_code);
+        return 1;
+    }
+
+    remove(trainerFile);
+
+    int trainerMismatches = memcmp(loadedTrainer.classCounts, halvesTrainer.classCounts, sizeof(halvesTrainer.classCounts)) != 0 ||
+        memcmp(loadedTrainer.classMeans, halvesTrainer.classMeans, sizeof(halvesTrainer.classMeans)) != 0 ||
+        memcmp(loadedTrainer.classScatters, halvesTrainer.classScatters, sizeof(halvesTrainer.classScatters)) != 0 ||
+        memcmp(loadedTrainer.coefficients, halvesTrainer.coefficients, sizeof(halvesTrainer.coefficients)) != 0 ||
+        memcmp(loadedTrainer.information, halvesTrainer.information, sizeof(halvesTrainer.information)) != 0;
+
+    fprintf(stdout, "Trainer state file: %s\n", trainerMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += trainerMismatches;
+
+    // Save the model as a JSON file and read it back.
+    const char* modelFile = "tests.model.json";
+
+    error_code = alifilter_saveTrainerModel(modelFile, &halvesTrainer);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while saving the model!\n", error_code);
+        return 1;
+    }
+
+    error_code = alifilter_parseModel(modelFile, &savedModel);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    remove(modelFile);
+
+    alifilter_getTrainerModel(&halvesTrainer, &trainedModel);
+
+    int modelMismatches = savedModel.intercept != trainedModel.intercept || savedModel.threshold != trainedModel.threshold;
+
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+        modelMismatches += savedModel.coefficients[j] != trainedModel.coefficients[j];
+    }
+
+    fprintf(stdout, "Model file: %s\n", modelMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += modelMismatches;
+
+    // Free memory
+    free(mask);
+    free(columnScores);
+    free(labels);
+    free(alignmentFeatures);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Reads a whole file into memory (used by the BGZF test). Returns NULL if the file cannot be read.
+unsigned char* readWholeFile(const char* fileName, size_t* out_length) {
+    FILE* fileH = fopen(fileName, "rb");
+    if (fileH == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 1 << 16;
+    size_t length = 0;
+    unsigned char* data = (unsigned char*)malloc(capacity);
+
+    while (data != NULL) {
+        length += fread(data + length, 1, capacity - length, fileH);
+
+        if (length < capacity) {
+            break;
+        }
+
+        unsigned char* newData = (unsigned char*)realloc(data, capacity * 2);
+        if (newData == NULL) {
+            free(data);
+        }
+
+        data = newData;
+        capacity *= 2;
+    }
+
+    if (ferror(fileH)) {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(fileH);
+    *out_length = length;
+    return data;
+}
+
+int testBGZF(char* argv[]) {
+    // Save the filtered alignment as a BGZF file with an index, and read it back.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alignment filteredAlignment;
+    alifilter_model model;
+    uint64_t* compressedOffsets;
+    uint64_t* uncompressedOffsets;
+    long long blockCount;
+    unsigned char* blockData;
+    unsigned char* singleThreadData;
+    unsigned char* multiThreadData;
+    unsigned char* uncompressedData;
+    char* mask;
+    int error_code;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    // Create the mask.
+    mask = alifilter_getMask(model, sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength);
+    if (mask == NULL) {
+        fprintf(stderr, "Error while creating the alignment mask!\n");
+        return 1;
+    }
+
+    // Save the filtered alignment in FASTA format, compressing the blocks on one thread and on four threads. The
+    // blocks are independent, so the files should be identical.
+    const char* bgzfFile = "tests.fasta.gz";
+    const char* indexFile = "tests.fasta.gz.gzi";
+    const char* fastaFile = "tests.fasta";
+    size_t singleThreadLength;
+    size_t multiThreadLength;
+    int mismatches = 0;
+
+    error_code = alifilter_saveFilteredAlignmentBGZF(bgzfFile, NULL, &sequenceAlignment, mask, ALIFILTER_FORMAT_FASTA, 1);
+    singleThreadData = error_code == 0 ? readWholeFile(bgzfFile, &singleThreadLength) : NULL;
+
+    if (error_code == 0) {
+        error_code = alifilter_saveFilteredAlignmentBGZF(bgzfFile, indexFile, &sequenceAlignment, mask, ALIFILTER_FORMAT_FASTA, 4);
+    }
+
+    multiThreadData = error_code == 0 ? readWholeFile(bgzfFile, &multiThreadLength) : NULL;
+
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while saving the BGZF file!\n", error_code);
+        return 1;
+    }
+
+    if (singleThreadData == NULL || multiThreadData == NULL) {
+        fprintf(stderr, "Error while reading the BGZF file!\n");
+        return 1;
+    }
+
+    int threadMismatches = singleThreadLength != multiThreadLength || memcmp(singleThreadData, multiThreadData, singleThreadLength) != 0;
+    fprintf(stdout, "1 thread vs 4 threads: %s\n", threadMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += threadMismatches;
+
+    // Read each block on its own, using the offsets from the index, and put them together.
+    error_code = alifilter_readBGZFIndex(indexFile, &compressedOffsets, &uncompressedOffsets, &blockCount);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the index!\n", error_code);
+        return 1;
+    }
+
+    blockData = (unsigned char*)malloc(ALIFILTER_BGZF_MAX_BLOCK_SIZE);
+    uncompressedData = (unsigned char*)malloc((size_t)blockCount * ALIFILTER_BGZF_BLOCK_SIZE);
+
+    if (blockData == NULL || uncompressedData == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    size_t uncompressedLength = 0;
+    int blockMismatches = 0;
+
+    for (long long i = 0; i < blockCount; i++) {
+        int blockLength;
+
+        error_code = alifilter_readBGZFBlock(bgzfFile, compressedOffsets[i], blockData, &blockLength);
+        if (error_code != 0) {
+            fprintf(stderr, "Error %d while reading block %lld!\n", error_code, i);
+            return 1;
+        }
+
+        if (uncompressedOffsets[i] != uncompressedLength || blockLength > ALIFILTER_BGZF_BLOCK_SIZE) {
+            blockMismatches++;
+            break;
+        }
+
+        memcpy(uncompressedData + uncompressedLength, blockData, blockLength);
+        uncompressedLength += blockLength;
+    }
+
+    // Parse the blocks as a FASTA file: the sequences should be the preserved columns of the alignment.
+    FILE* fileH = fopen(fastaFile, "wb");
+    if (fileH == NULL || fwrite(uncompressedData, 1, uncompressedLength, fileH) != uncompressedLength || fclose(fileH) != 0) {
+        fprintf(stderr, "Error while writing the FASTA file!\n");
+        return 1;
+    }
+
+    error_code = fasta_parseFASTA(fastaFile, &filteredAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the FASTA file!\n", error_code);
+        return 1;
+    }
+
+    blockMismatches += filteredAlignment.sequenceCount != sequenceAlignment.sequenceCount;
+
+    for (int i = 0; i < filteredAlignment.sequenceCount && blockMismatches == 0; i++) {
+        int column = 0;
+
+        blockMismatches += strcmp(phylip_getSequenceName(&filteredAlignment, i), phylip_getSequenceName(&sequenceAlignment, i)) != 0;
+
+        for (int j = 0; j < sequenceAlignment.alignmentLength; j++) {
+            if (mask[j] == '1') {
+                blockMismatches += column >= filteredAlignment.alignmentLength || filteredAlignment.sequenceData[i * filteredAlignment.alignmentLength + column] != sequenceAlignment.sequenceData[i * sequenceAlignment.alignmentLength + j];
+                column++;
+            }
+        }
+
+        blockMismatches += column != filteredAlignment.alignmentLength;
+    }
+
+    fprintf(stdout, "%lld blocks read using the index: %s\n", blockCount, blockMismatches == 0 ? "OK" : "MISMATCH");
+    mismatches += blockMismatches;
+
+    // Decompress the whole file with gzip (if it is available), which should give the same data.
+    if (system(NULL) != 0 && system("gzip -dc tests.fasta.gz > tests.fasta") == 0) {
+        size_t gzipLength;
+        unsigned char* gzipData = readWholeFile(fastaFile, &gzipLength);
+
+        int gzipMismatches = gzipData == NULL || gzipLength != uncompressedLength || memcmp(gzipData, uncompressedData, uncompressedLength) != 0;
+        fprintf(stdout, "gzip -dc: %s\n", gzipMismatches == 0 ? "OK" : "MISMATCH");
+        mismatches += gzipMismatches;
+
+        free(gzipData);
+    }
+    else {
+        fprintf(stdout, "gzip -dc: skipped (gzip is not available)\n");
+    }
+
+    remove(fastaFile);
+    remove(indexFile);
+    remove(bgzfFile);
+
+    // Free memory
+    free(uncompressedData);
+    free(blockData);
+    free(compressedOffsets);
+    free(uncompressedOffsets);
+    free(multiThreadData);
+    free(singleThreadData);
+    free(mask);
+    phylip_freeAlignment(&filteredAlignment);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+int testSweep(char* argv[]) {
+    // Run a mistake-rate sweep on the alignment, using the mask from the model file as the labels, and check
+    // that the results do not depend on the number of threads.
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_model model;
+    alifilter_featureMatrix trainingData;
+    alifilter_sweepResult* singleThreadResults;
+    alifilter_sweepResult* multiThreadResults;
+    int error_code;
+
+    const double mistakeRates[] = { 0, 0.05, 0.1, 0.2 };
+    const int rateCount = sizeof(mistakeRates) / sizeof(mistakeRates[0]);
+    const int replicateCount = 3;
+    const int resultCount = rateCount * replicateCount;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the model file.
+    error_code = alifilter_parseModel(argv[2], &model);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the model file!\n", error_code);
+        return 1;
+    }
+
+    // Compute the alignment features and use the mask as the labels (this is what alifilter_readFeatureFile would read
+    // from a feature file created by the command-line program).
+    trainingData.columnCount = sequenceAlignment.alignmentLength;
+    trainingData.features = alifilter_getAlignmentFeatures(sequenceAlignment.sequenceData, sequenceAlignment.sequenceCount, sequenceAlignment.alignmentLength);
+    if (trainingData.features == NULL) {
+        fprintf(stderr, "Error while computing alignment features!\n");
+        return 1;
+    }
+
+    trainingData.mask = alifilter_getMaskFromFeatures(model, trainingData.features, trainingData.columnCount);
+    singleThreadResults = (alifilter_sweepResult*)malloc(resultCount * sizeof(alifilter_sweepResult));
+    multiThreadResults = (alifilter_sweepResult*)malloc(resultCount * sizeof(alifilter_sweepResult));
+
+    if (trainingData.mask == NULL || singleThreadResults == NULL || multiThreadResults == NULL) {
+        fprintf(stderr, "Error while allocating memory!\n");
+        return 1;
+    }
+
+    // Run the same sweep with one thread and with four threads.
+    error_code = alifilter_runMistakeSweep(&trainingData, NULL, mistakeRates, rateCount, replicateCount, 12345, 1, singleThreadResults);
+    if (error_code == 0) {
+        error_code = alifilter_runMistakeSweep(&trainingData, NULL, mistakeRates, rateCount, replicateCount, 12345, 4, multiThreadResults);
+    }
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while running the sweep!\n", error_code);
+        return 1;
+    }
+
+    alifilter_writeSweepResults(stdout, multiThreadResults, resultCount);
+
+    // Every grid point should have been fitted (including the ones without mistakes, whose labels are separable), and the
+    // models without mistakes should reproduce the labels exactly.
+    int failedMismatches = 0;
+
+    for (int i = 0; i < resultCount; i++) {
+        failedMismatches += multiThreadResults[i].result != 0 || (multiThreadResults[i].mistakeRate == 0 && multiThreadResults[i].accuracy != 1);
+    }
+
+    fprintf(stdout, "Fitted models: %s\n", failedMismatches == 0 ? "OK" : "MISMATCH");
+
+    // Each grid point uses its own random stream, so the results should be the same regardless of the number of threads.
+    int threadMismatches = 0;
+
+    for (int i = 0; i < resultCount; i++) {
+        const alifilter_sweepResult* a = &singleThreadResults[i];
+        const alifilter_sweepResult* b = &multiThreadResults[i];
+
+        threadMismatches += a->mistakeRate != b->mistakeRate || a->replicate != b->replicate || a->result != b->result ||
+            a->incorrectlyPreserved != b->incorrectlyPreserved || a->incorrectlyDeleted != b->incorrectlyDeleted ||
+            a->truePositives != b->truePositives || a->trueNegatives != b->trueNegatives || a->falsePositives != b->falsePositives ||
+            a->falseNegatives != b->falseNegatives || a->bestThreshold != b->bestThreshold ||
+            memcmp(&a->model, &b->model, sizeof(alifilter_model)) != 0;
+    }
+
+    fprintf(stdout, "Results with 1 and 4 threads: %s\n", threadMismatches == 0 ? "OK" : "MISMATCH");
+
+    // Free memory
+    free(multiThreadResults);
+    free(singleThreadResults);
+    free(trainingData.mask);
+    free(trainingData.features);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return failedMismatches + threadMismatches == 0 ? 0 : 1;
+}
+
+// Copies a block of columns from some of the sequences of an alignment (used by the feature file test).
+char* copyColumns(alignment sequenceAlignment, int firstSequence, int sequenceCount, int firstColumn, int columnCount) {
+    char* tbr = (char*)malloc((size_t)sequenceCount * columnCount);
+
+    if (tbr != NULL) {
+        for (int i = 0; i < sequenceCount; i++) {
+            memcpy(&tbr[(size_t)i * columnCount], &sequenceAlignment.sequenceData[(size_t)(firstSequence + i) * sequenceAlignment.alignmentLength + firstColumn], columnCount);
+        }
+    }
+
+    return tbr;
+}
+
+int testFeatureFile(char* argv[]) {
+    // Read a feature file created by the C# library (two alignments, with bootstrap replicates and a column with a
+    // non-finite feature), and compare it with the features computed from the same columns.
+    //
+    // Data/example.features.bin contains two gzip streams, created with the feature computation and the file writer of
+    // the C# library (as in "AliFilter -i <alignment> --mask <mask> -o <feature file>", appending the second alignment):
+    //     • sequences 0-39 and columns 1000-1049 of example.phy, with 3 bootstrap replicates, where one feature of the
+    //       last replicate of column 7 has been replaced by NaN (so this column should be skipped);
+    //     • sequences 100-139 and columns 2000-2029 of example.phy, with 3 bootstrap replicates.
+    // In both, column j is labelled as preserved unless j is a multiple of 3. Data/incompatible.features.bin was created
+    // in the same way, but with program version 1.0.0.131072 (whose features are not compatible).
+
+    // Declare variables.
+    alignment sequenceAlignment;
+    alifilter_featureMatrix features;
+    alifilter_featureMatrix incompatibleFeatures;
+    alifilter_sweepResult results[4];
+    int error_code;
+
+    const int firstSequences[2] = { 0, 100 };
+    const int firstColumns[2] = { 1000, 2000 };
+    const int columnCounts[2] = { 50, 30 };
+    const int sequenceCount = 40;
+    const int skippedColumn = 7;
+
+    // Read the alignment file.
+    error_code = phylip_parsePHYLIP(argv[1], &sequenceAlignment);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while reading the alignment file!\n", error_code);
+        return 1;
+    }
+
+    // Read the feature file.
+    error_code = alifilter_readFeatureFile(argv[3], &features);
+    if (error_code != 0 && error_code != 5) {
+        fprintf(stderr, "Error %d while reading the feature file!\n", error_code);
+        return 1;
+    }
+
+    int columnMismatches = features.columnCount != columnCounts[0] + columnCounts[1] - 1;
+    int labelMismatches = 0;
+    double maxDifference = 0;
+
+    // Compute the features of the same columns, and compare them with the ones that have been read.
+    for (int k = 0, index = 0; k < 2 && columnMismatches == 0; k++) {
+        char* sequenceData = copyColumns(sequenceAlignment, firstSequences[k], sequenceCount, firstColumns[k], columnCounts[k]);
+        double* expectedFeatures = sequenceData != NULL ? alifilter_getAlignmentFeatures(sequenceData, sequenceCount, columnCounts[k]) : NULL;
+
+        if (expectedFeatures == NULL) {
+            fprintf(stderr, "Error while computing alignment features!\n");
+            return 1;
+        }
+
+        for (int j = 0; j < columnCounts[k]; j++) {
+            if (k == 0 && j == skippedColumn) {
+                continue;
+            }
+
+            labelMismatches += features.mask[index] != (j % 3 != 0 ? '1' : '0');
+
+            for (int f = 0; f < ALIFILTER_FEATURE_COUNT; f++) {
+                maxDifference = MAX(maxDifference, fabs(features.features[index * ALIFILTER_FEATURE_COUNT + f] - expectedFeatures[j * ALIFILTER_FEATURE_COUNT + f]));
+            }
+
+            index++;
+        }
+
+        free(expectedFeatures);
+        free(sequenceData);
+    }
+
+    fprintf(stdout, "Columns (skipping the non-finite one): %s\n", columnMismatches == 0 ? "OK" : "MISMATCH");
+    fprintf(stdout, "Labels: %s\n", labelMismatches == 0 ? "OK" : "MISMATCH");
+
+    int featureMismatches = columnMismatches != 0 || maxDifference > 1e-12;
+    fprintf(stdout, "Features (max difference %g): %s\n", maxDifference, featureMismatches == 0 ? "OK" : "MISMATCH");
+
+    // The file with an incompatible program version should be rejected.
+    error_code = alifilter_readFeatureFile(argv[4], &incompatibleFeatures);
+    if (error_code == 0 || error_code == 5) {
+        alifilter_freeFeatureMatrix(&incompatibleFeatures);
+    }
+
+    int versionMismatches = error_code != 2;
+    fprintf(stdout, "Incompatible program version: %s\n", versionMismatches == 0 ? "OK" : "MISMATCH");
+
+    // Run a small sweep on the features that have been read.
+    const double mistakeRates[] = { 0, 0.1 };
+
+    error_code = alifilter_runMistakeSweep(&features, NULL, mistakeRates, 2, 2, 1, 0, results);
+    if (error_code != 0) {
+        fprintf(stderr, "Error %d while running the sweep!\n", error_code);
+        return 1;
+    }
+
+    int sweepMismatches = 0;
+
+    for (int i = 0; i < 4; i++) {
+        sweepMismatches += results[i].result != 0 || results[i].truePositives + results[i].trueNegatives + results[i].falsePositives + results[i].falseNegatives != features.columnCount;
+    }
+
+    fprintf(stdout, "Sweep on the feature file: %s\n", sweepMismatches == 0 ? "OK" : "MISMATCH");
+
+    // Free memory
+    alifilter_freeFeatureMatrix(&features);
+    phylip_freeAlignment(&sequenceAlignment);
+
+    return columnMismatches + labelMismatches + featureMismatches + versionMismatches + sweepMismatches == 0 ? 0 : 1;
+}
@@ -20,7 +20,18 @@ import math
 import numpy
 import json
 import array
+import os
+import itertools
+import concurrent.futures
 import Bio.Align
+import Bio.AlignIO
+
+# Native implementation of the AliFilter API (built with "python setup.py build_ext --inplace"). If this is not
+# available, a slower implementation based on NumPy is used.
+try:
+    import _alifilter
+except ImportError:
+    _alifilter = None
 
 class AliFilterModel:
     def __init__(self, modelFilePath):
@@ -37,81 +48,155 @@ class AliFilterModel:
             self.threshold = 0.5
     
     def getScores(self, features):
-        return array.array('d', map(lambda x: 1 / (1 + math.exp(-(x + self.logisticModelIntercept))), numpy.squeeze(numpy.dot(features, self.logisticModelCoefficients))))
+        features = numpy.ascontiguousarray(features, dtype=numpy.float64)
+        
+        if _alifilter is not None:
+            return numpy.frombuffer(_alifilter.getScores(features, self.logisticModelCoefficients[:, 0].tolist(), self.logisticModelIntercept), dtype=numpy.float64)
+        else:
+            return 1 / (1 + numpy.exp(-(numpy.dot(features, self.logisticModelCoefficients)[:, 0] + self.logisticModelIntercept)))
     
     def getMaskFromScores(self, scores):
-        return ''.join(map(lambda x: '1' if x >= self.threshold else '0', scores))
+        return numpy.where(numpy.asarray(scores) >= self.threshold, ord('1'), ord('0')).astype(numpy.uint8).tobytes().decode('ascii')
     
     def getMaskFromFeatures(self, features):
         return self.getMaskFromScores(self.getScores(features))
     
     def getMask(self, alignment):
-        return self.getMaskFromFeatures(alignment.getAlignmentFeatures())
-    
-    def filter(self, alignment):
-        scores = self.getScores(alignment.getAlignmentFeatures())
-        return Bio.Align.MultipleSeqAlignment(map(lambda seq: Bio.SeqRecord.SeqRecord(Bio.Seq.Seq(''.join(seq.seq[i] for i in range(len(scores)) if scores[i] >= self.threshold)), seq.id, seq.name, seq.description, seq.dbxrefs, seq.features, seq.annotations, seq.letter_annotations), alignment))
-
-def __alifilter_computeColumnFeatures(alignment, column, feature_matrix):
-    gapCount = 0
-    counts = numpy.zeros(26, 'i')
-    validChars = 0
+        if _alifilter is not None:
+            return _alifilter.getMask(getSequenceMatrix(alignment), self.logisticModelCoefficients[:, 0].tolist(), self.logisticModelIntercept, self.threshold).decode('ascii')
+        else:
+            return self.getMaskFromFeatures(getAlignmentFeatures(alignment))
     
-    for i in range(len(alignment)):
-        c = alignment[i][column]
+    # Computes the masks for multiple alignments, yielding them (in the same order as the input) as they become
+    # available. Each alignment can be a path to an alignment file in FASTA or relaxed PHYLIP format, a
+    # Bio.Align.MultipleSeqAlignment or a two-dimensional numpy.uint8 array. alignments can be any iterable (including a
+    # generator): it is consumed in batches of batchSize alignments, and the next batch is prepared while the previous one
+    # is being processed. When the native implementation is available, each batch is processed on the specified number
+    # of threads (0 = one per processor) without holding the GIL, and alignment files are also read without holding it.
+    def getMasks(self, alignments, threads=0, batchSize=None):
+        if batchSize is None:
+            batchSize = 4 * (threads if threads > 0 else (os.cpu_count() or 1))
         
-        if (c == '-'):
-            gapCount += 1
-        else:
-            C = ord(c.upper())
-            if C >= 65 and C <= 90:
-                validChars += 1
-                counts[C - 65] += 1
+        alignments = iter(alignments)
+        coefficients = self.logisticModelCoefficients[:, 0].tolist()
+        
+        with concurrent.futures.ThreadPoolExecutor(max_workers=1) as executor:
+            pending = None
+            
+            while True:
+                batch = [ _getBatchItem(alignment) for alignment in itertools.islice(alignments, batchSize) ]
+                
+                # Start processing the new batch before returning the results of the previous one.
+                current = executor.submit(self.__getBatchMasks, batch, coefficients, threads) if len(batch) > 0 else None
+                
+                if pending is not None:
+                    yield from pending.result()
+                
+                if current is None:
+                    break
+                
+                pending = current
     
-    # % Gaps
-    feature_matrix[column, 0] = gapCount / len(alignment)
+    def __getBatchMasks(self, batch, coefficients, threads):
+        if _alifilter is not None:
+            masks = _alifilter.getMasks(batch, coefficients, self.logisticModelIntercept, self.threshold, threads)
+        else:
+            masks = [ self.getMask(_readAlignment(item) if isinstance(item, (str, bytes, os.PathLike)) else item) for item in batch ]
+        
+        for item, mask in zip(batch, masks):
+            if isinstance(mask, int):
+                raise ValueError("Error {0} while processing alignment {1}!".format(mask, item if isinstance(item, (str, bytes, os.PathLike)) else "data"))
+        
+        return [ mask.decode('ascii') if isinstance(mask, bytes) else mask for mask in masks ]
     
-    # % Identity and entropy
-    if validChars > 0:
-        maxId = max(counts)
-        entropy = sum(map(lambda x: 0 if x <= 0 else - x / validChars * math.log(x / validChars), counts))
+    def filter(self, alignment):
+        sequenceMatrix = getSequenceMatrix(alignment)
+        filteredMatrix = sequenceMatrix[:, self.getScores(getAlignmentFeatures(sequenceMatrix)) >= self.threshold]
+        
+        if isinstance(alignment, Bio.Align.MultipleSeqAlignment):
+            return Bio.Align.MultipleSeqAlignment(map(lambda seq, filteredSeq: Bio.SeqRecord.SeqRecord(Bio.Seq.Seq(filteredSeq.tobytes()), seq.id, seq.name, seq.description, seq.dbxrefs, seq.features, seq.annotations), alignment, filteredMatrix))
+        else:
+            return filteredMatrix
+
+# Returns the alignment as a two-dimensional numpy.uint8 array with one row for each sequence. Only an alignment that is
+# already a C-contiguous numpy.uint8 array (or another object exposing such a buffer) is used without copying it; the
+# sequences of a Bio.Align.MultipleSeqAlignment are copied once, directly into the new matrix, and arrays with a
+# different type or layout are converted by NumPy.
+def getSequenceMatrix(alignment):
+    if isinstance(alignment, Bio.Align.MultipleSeqAlignment):
+        sequenceMatrix = numpy.empty((len(alignment), alignment.get_alignment_length()), dtype=numpy.uint8)
         
-        feature_matrix[column, 1] = maxId / len(alignment)
-        feature_matrix[column, 3] = entropy
+        for i, seq in enumerate(alignment):
+            sequenceMatrix[i, :] = numpy.frombuffer(bytes(seq.seq), dtype=numpy.uint8)
+        
+        return sequenceMatrix
+    else:
+        return numpy.ascontiguousarray(alignment, dtype=numpy.uint8)
+
+# (Single underscore: these are called from AliFilterModel methods, where double underscores would be mangled.)
+# Converts an alignment in a batch to something that can be passed to the native implementation (alignment files are
+# passed as paths, everything else as a sequence matrix).
+def _getBatchItem(alignment):
+    if isinstance(alignment, (str, bytes, os.PathLike)):
+        return alignment
     else:
-        feature_matrix[column, 1] = 0
-        feature_matrix[column, 3] = 0
+        return getSequenceMatrix(alignment)
+
+# Reads an alignment file in FASTA or relaxed PHYLIP format, detecting the format from the first character in the file.
+def _readAlignment(alignmentFile):
+    with open(alignmentFile) as fileH:
+        isFasta = fileH.read(4096).lstrip().startswith('>')
     
-    # Distance from extremity
-    feature_matrix[column, 2] = min(column, alignment.get_alignment_length() - 1 - column)
+    return Bio.AlignIO.read(alignmentFile, format='fasta' if isFasta else 'phylip-relaxed')
+
+# Computes the alignment features for an alignment (either a Bio.Align.MultipleSeqAlignment or a two-dimensional
+# numpy.uint8 array with one row for each sequence). Returns a numpy array with one row for each alignment column.
+def getAlignmentFeatures(alignment):
+    sequenceMatrix = getSequenceMatrix(alignment)
     
-    # % Gaps +- 1 and % Gaps +- 2 are not computed here.
+    if _alifilter is not None:
+        return numpy.frombuffer(_alifilter.getAlignmentFeatures(sequenceMatrix), dtype=numpy.float64).reshape(sequenceMatrix.shape[1], 6)
+    else:
+        return __alifilter_getAlignmentFeatures(sequenceMatrix)
 
-def __alifilter_getAlignmentFeatures(alignment):
-    alignmentLength = alignment.get_alignment_length()
+def __alifilter_getAlignmentFeatures(sequenceMatrix):
+    sequenceCount, alignmentLength = sequenceMatrix.shape
     features = numpy.zeros([alignmentLength, 6])
     
-    # Compute % Gaps, % Identity, Distance from extremity and Entropy.
-    for i in range(alignmentLength):
-        __alifilter_computeColumnFeatures(alignment, i, features)
+    # Convert lower case letters to upper case.
+    upperMatrix = numpy.where((sequenceMatrix >= ord('a')) & (sequenceMatrix <= ord('z')), sequenceMatrix - 32, sequenceMatrix)
+    
+    # Count the residues of each kind in each column.
+    counts = numpy.zeros([26, alignmentLength])
+    for i in range(26):
+        counts[i] = numpy.count_nonzero(upperMatrix == 65 + i, axis=0)
+    
+    validChars = counts.sum(axis=0)
+    
+    # % Gaps
+    features[:, 0] = numpy.count_nonzero(sequenceMatrix == ord('-'), axis=0) / sequenceCount
+    
+    # % Identity and entropy
+    with numpy.errstate(divide='ignore', invalid='ignore'):
+        frequencies = numpy.where(counts > 0, counts / numpy.maximum(validChars, 1), 1)
+        features[:, 1] = counts.max(axis=0) / sequenceCount
+        features[:, 3] = -(frequencies * numpy.log(frequencies)).sum(axis=0)
+    
+    # Distance from extremity
+    columns = numpy.arange(alignmentLength)
+    features[:, 2] = numpy.minimum(columns, alignmentLength - 1 - columns)
     
     # Compute % Gaps +- 1 and +- 2
-    for i in range(alignmentLength):
-        # % Gaps +- 1
-        features[i, 4] = (((features[i - 1, 0] if i > 0 else 0) +
-                           features[i, 0] +
-                           (features[i + 1, 0] if i < alignmentLength - 1 else 0)) /
-                           (1 + (1 if i > 0 else 0) + (1 if i < alignmentLength - 1 else 0)))
-        
-        # % Gaps +- 2
-        features[i, 5] = (((features[i - 2, 0] if i > 1 else 0) +
-                           (features[i - 1, 0] if i > 0 else 0) +
-                           features[i, 0] +
-                           (features[i + 1, 0] if i < alignmentLength - 1 else 0) +
-                           (features[i + 2, 0] if i < alignmentLength - 2 else 0)) /
-                           (1 + (2 if i > 1 else (1 if i > 0 else 0)) + (2 if i < alignmentLength - 2 else (1 if i < alignmentLength - 1 else 0))))
+    paddedGaps = numpy.concatenate(([0, 0], features[:, 0], [0, 0]))
+    paddedCounts = numpy.concatenate(([0, 0], numpy.ones(alignmentLength), [0, 0]))
+    
+    # % Gaps +- 1
+    features[:, 4] = (paddedGaps[1:-3] + paddedGaps[2:-2] + paddedGaps[3:-1]) / (paddedCounts[1:-3] + paddedCounts[2:-2] + paddedCounts[3:-1])
+    
+    # % Gaps +- 2
+    features[:, 5] = (paddedGaps[:-4] + paddedGaps[1:-3] + paddedGaps[2:-2] + paddedGaps[3:-1] + paddedGaps[4:]) / (paddedCounts[:-4] + paddedCounts[1:-3] + paddedCounts[2:-2] + paddedCounts[3:-1] + paddedCounts[4:])
     
     return features
 
-Bio.Align.MultipleSeqAlignment.getAlignmentFeatures = __alifilter_getAlignmentFeatures
+Bio.Align.MultipleSeqAlignment.getAlignmentFeatures = getAlignmentFeatures
 Bio.Align.MultipleSeqAlignment.filter = lambda self, model: model.filter(self)
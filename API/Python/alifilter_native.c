@@ -0,0 +1,424 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Python extension module (_alifilter) exposing the AliFilter C API. Alignments and features are accessed through the
+// buffer protocol (e.g., NumPy arrays) without copying them, and results are returned as bytearray objects that can be
+// wrapped by NumPy without copying. The GIL is released while the computations are running, and batches of alignments
+// are processed on multiple threads.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <limits.h>
+#include <string.h>
+
+#define ALIFILTER_IMPLEMENTATION
+#define ALIFILTER_PHYLIP_IMPLEMENTATION
+#define ALIFILTER_FASTA_IMPLEMENTATION
+#define ALIFILTER_THREADS_IMPLEMENTATION
+#define ALIFILTER_PYRAMID_IMPLEMENTATION
+#define ALIFILTER_BATCH_IMPLEMENTATION
+#include "alifilter_batch.h"
+
+// Checks whether the format of a buffer (in struct module syntax) is one of the specified single-character formats, in
+// native or little-endian byte order (a NULL format means unsigned bytes).
+static int alifilter_native_checkFormat(const char* format, const char* validFormats) {
+    if (format == NULL) {
+        format = "B";
+    }
+
+#if PY_LITTLE_ENDIAN
+    if (format[0] == '@' || format[0] == '=' || format[0] == '<') {
+#else
+    if (format[0] == '@' || format[0] == '=') {
+#endif
+        format++;
+    }
+
+    return format[0] != '\0' && format[1] == '\0' && strchr(validFormats, format[0]) != NULL;
+}
+
+// Obtains a read-only, C-contiguous view of a two-dimensional buffer with the specified item size, whose format is one of
+// the specified single-character formats (e.g., "d" for doubles, or "Bbc" for bytes).
+//   Return value: 0 on success, -1 on failure (in which case a Python exception has been set).
+static int alifilter_native_getMatrix(PyObject* obj, Py_buffer* view, Py_ssize_t itemSize, const char* validFormats, const char* name) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return -1;
+    }
+
+    if (!alifilter_native_checkFormat(view->format, validFormats)) {
+        PyErr_Format(PyExc_TypeError, "%s has an invalid item format (%s)!", name, view->format != NULL ? view->format : "B");
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    if (view->ndim != 2 || view->itemsize != itemSize) {
+        PyErr_Format(PyExc_ValueError, "%s should be a two-dimensional C-contiguous buffer with items of size %zd!", name, itemSize);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    if (view->shape[0] < 1 || view->shape[1] < 1 || view->shape[0] > INT_MAX || view->shape[1] > INT_MAX) {
+        PyErr_Format(PyExc_ValueError, "Invalid %s size (%zd x %zd)!", name, view->shape[0], view->shape[1]);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Creates an alifilter_model from the model parameters.
+//   Return value: 0 on success, -1 on failure (in which case a Python exception has been set).
+static int alifilter_native_getModel(PyObject* coefficients, double intercept, double threshold, alifilter_model* out_model) {
+    PyObject* sequence = PySequence_Fast(coefficients, "The model coefficients should be a sequence!");
+
+    if (sequence == NULL) {
+        return -1;
+    }
+
+    if (PySequence_Fast_GET_SIZE(sequence) != ALIFILTER_FEATURE_COUNT) {
+        PyErr_Format(PyExc_ValueError, "The model should contain %d coefficients!", ALIFILTER_FEATURE_COUNT);
+        Py_DECREF(sequence);
+        return -1;
+    }
+
+    for (int i = 0; i < ALIFILTER_FEATURE_COUNT; i++) {
+        out_model->coefficients[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(sequence, i));
+
+        if (out_model->coefficients[i] == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(sequence);
+            return -1;
+        }
+    }
+
+    Py_DECREF(sequence);
+
+    out_model->intercept = intercept;
+    out_model->threshold = threshold;
+
+    return 0;
+}
+
+PyDoc_STRVAR(alifilter_native_getAlignmentFeatures_doc,
+"getAlignmentFeatures(sequenceData)\n"
+"--\n\n"
+"Computes the alignment features.\n\n"
+"sequenceData should be a two-dimensional C-contiguous buffer of bytes (e.g., a numpy.uint8 array) with one row for\n"
+"each sequence. Returns a bytearray containing alignmentLength * 6 doubles.");
+
+static PyObject* alifilter_native_getAlignmentFeatures(PyObject* self, PyObject* args) {
+    (void)self;
+
+    PyObject* sequenceDataObj;
+
+    if (!PyArg_ParseTuple(args, "O:getAlignmentFeatures", &sequenceDataObj)) {
+        return NULL;
+    }
+
+    Py_buffer sequenceData;
+
+    if (alifilter_native_getMatrix(sequenceDataObj, &sequenceData, 1, "Bbc", "sequenceData") != 0) {
+        return NULL;
+    }
+
+    int sequenceCount = (int)sequenceData.shape[0];
+    int alignmentLength = (int)sequenceData.shape[1];
+
+    PyObject* features = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t)alignmentLength * ALIFILTER_FEATURE_COUNT * sizeof(double));
+
+    if (features != NULL) {
+        double* out_features = (double*)PyByteArray_AS_STRING(features);
+
+        Py_BEGIN_ALLOW_THREADS
+        alifilter_computeAlignmentFeatures((const char*)sequenceData.buf, sequenceCount, alignmentLength, out_features);
+        Py_END_ALLOW_THREADS
+    }
+
+    PyBuffer_Release(&sequenceData);
+
+    return features;
+}
+
+PyDoc_STRVAR(alifilter_native_getScores_doc,
+"getScores(features, coefficients, intercept)\n"
+"--\n\n"
+"Computes the column scores from pre-computed alignment features.\n\n"
+"features should be a two-dimensional C-contiguous buffer of doubles with 6 columns (e.g., the result of\n"
+"getAlignmentFeatures as a numpy.float64 array). Returns a bytearray containing one double for each alignment column.");
+
+static PyObject* alifilter_native_getScores(PyObject* self, PyObject* args) {
+    (void)self;
+
+    PyObject* featuresObj;
+    PyObject* coefficients;
+    double intercept;
+
+    if (!PyArg_ParseTuple(args, "OOd:getScores", &featuresObj, &coefficients, &intercept)) {
+        return NULL;
+    }
+
+    alifilter_model model;
+
+    if (alifilter_native_getModel(coefficients, intercept, 0.5, &model) != 0) {
+        return NULL;
+    }
+
+    Py_buffer features;
+
+    if (alifilter_native_getMatrix(featuresObj, &features, sizeof(double), "d", "features") != 0) {
+        return NULL;
+    }
+
+    if (features.shape[1] != ALIFILTER_FEATURE_COUNT) {
+        PyErr_Format(PyExc_ValueError, "features should have %d columns!", ALIFILTER_FEATURE_COUNT);
+        PyBuffer_Release(&features);
+        return NULL;
+    }
+
+    int alignmentLength = (int)features.shape[0];
+
+    PyObject* scores = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t)alignmentLength * sizeof(double));
+
+    if (scores != NULL) {
+        double* out_scores = (double*)PyByteArray_AS_STRING(scores);
+
+        Py_BEGIN_ALLOW_THREADS
+        alifilter_computeScores(model, (const double*)features.buf, alignmentLength, out_scores);
+        Py_END_ALLOW_THREADS
+    }
+
+    PyBuffer_Release(&features);
+
+    return scores;
+}
+
+PyDoc_STRVAR(alifilter_native_getMask_doc,
+"getMask(sequenceData, coefficients, intercept, threshold)\n"
+"--\n\n"
+"Computes the alignment mask.\n\n"
+"sequenceData should be a two-dimensional C-contiguous buffer of bytes (e.g., a numpy.uint8 array) with one row for\n"
+"each sequence. Returns a bytes object containing 1s for columns that should be preserved and 0s for columns that\n"
+"should be deleted.");
+
+static PyObject* alifilter_native_getMask(PyObject* self, PyObject* args) {
+    (void)self;
+
+    PyObject* sequenceDataObj;
+    PyObject* coefficients;
+    double intercept;
+    double threshold;
+
+    if (!PyArg_ParseTuple(args, "OOdd:getMask", &sequenceDataObj, &coefficients, &intercept, &threshold)) {
+        return NULL;
+    }
+
+    alifilter_model model;
+
+    if (alifilter_native_getModel(coefficients, intercept, threshold, &model) != 0) {
+        return NULL;
+    }
+
+    Py_buffer sequenceData;
+
+    if (alifilter_native_getMatrix(sequenceDataObj, &sequenceData, 1, "Bbc", "sequenceData") != 0) {
+        return NULL;
+    }
+
+    int sequenceCount = (int)sequenceData.shape[0];
+    int alignmentLength = (int)sequenceData.shape[1];
+
+    PyObject* mask = PyBytes_FromStringAndSize(NULL, alignmentLength);
+    // Room for the features and the scores.
+    double* features = (double*)PyMem_RawMalloc((size_t)alignmentLength * (ALIFILTER_FEATURE_COUNT + 1) * sizeof(double));
+
+    if (mask != NULL && features != NULL) {
+        char* out_mask = PyBytes_AS_STRING(mask);
+
+        Py_BEGIN_ALLOW_THREADS
+        double* scores = features + (size_t)alignmentLength * ALIFILTER_FEATURE_COUNT;
+
+        alifilter_computeAlignmentFeatures((const char*)sequenceData.buf, sequenceCount, alignmentLength, features);
+        alifilter_computeScores(model, features, alignmentLength, scores);
+        alifilter_computeMaskFromScores(model, scores, alignmentLength, out_mask);
+        Py_END_ALLOW_THREADS
+    }
+    else if (features == NULL) {
+        Py_CLEAR(mask);
+        PyErr_NoMemory();
+    }
+
+    PyMem_RawFree(features);
+    PyBuffer_Release(&sequenceData);
+
+    return mask;
+}
+
+PyDoc_STRVAR(alifilter_native_getMasks_doc,
+"getMasks(alignments, coefficients, intercept, threshold, threads)\n"
+"--\n\n"
+"Computes the masks for a batch of alignments on multiple threads.\n\n"
+"Each element of alignments should be either the path to an alignment file in FASTA or relaxed PHYLIP format (which\n"
+"will be read without holding the GIL), or a two-dimensional C-contiguous buffer of bytes with one row for each\n"
+"sequence. If threads is less than or equal to 0, one thread per processor is used. Returns a list containing, for each\n"
+"alignment, either a bytes object with the mask, or an int error code if the alignment could not be processed.");
+
+static PyObject* alifilter_native_getMasks(PyObject* self, PyObject* args) {
+    (void)self;
+
+    PyObject* alignmentsObj;
+    PyObject* coefficients;
+    double intercept;
+    double threshold;
+    int threadCount;
+
+    if (!PyArg_ParseTuple(args, "OOddi:getMasks", &alignmentsObj, &coefficients, &intercept, &threshold, &threadCount)) {
+        return NULL;
+    }
+
+    alifilter_model model;
+
+    if (alifilter_native_getModel(coefficients, intercept, threshold, &model) != 0) {
+        return NULL;
+    }
+
+    PyObject* alignments = PySequence_Fast(alignmentsObj, "The alignments should be a sequence!");
+
+    if (alignments == NULL) {
+        return NULL;
+    }
+
+    Py_ssize_t itemCountSize = PySequence_Fast_GET_SIZE(alignments);
+
+    if (itemCountSize > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Too many alignments in the batch!");
+        Py_DECREF(alignments);
+        return NULL;
+    }
+
+    int itemCount = (int)itemCountSize;
+
+    // The file names (encoded using the file system encoding) and buffers must be kept alive while the GIL is released.
+    alifilter_batchItem* items = (alifilter_batchItem*)PyMem_Calloc(itemCount + 1, sizeof(alifilter_batchItem));
+    PyObject** fileNames = (PyObject**)PyMem_Calloc(itemCount + 1, sizeof(PyObject*));
+    Py_buffer* buffers = (Py_buffer*)PyMem_Calloc(itemCount + 1, sizeof(Py_buffer));
+
+    PyObject* masks = NULL;
+    int acquiredBuffers = 0;
+
+    if (items == NULL || fileNames == NULL || buffers == NULL) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    for (int i = 0; i < itemCount; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(alignments, i);
+
+        if (PyUnicode_Check(item) || PyBytes_Check(item) || PyObject_HasAttrString(item, "__fspath__")) {
+            if (!PyUnicode_FSConverter(item, &fileNames[i])) {
+                goto cleanup;
+            }
+
+            items[i].alignmentFile = PyBytes_AS_STRING(fileNames[i]);
+        }
+        else {
+            if (alifilter_native_getMatrix(item, &buffers[i], 1, "Bbc", "sequenceData") != 0) {
+                goto cleanup;
+            }
+
+            acquiredBuffers = i + 1;
+
+            items[i].alignmentFile = NULL;
+            items[i].sequenceData = (const char*)buffers[i].buf;
+            items[i].sequenceCount = (int)buffers[i].shape[0];
+            items[i].alignmentLength = (int)buffers[i].shape[1];
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    alifilter_getMasks(model, items, itemCount, threadCount);
+    Py_END_ALLOW_THREADS
+
+    masks = PyList_New(itemCount);
+
+    if (masks != NULL) {
+        for (int i = 0; i < itemCount; i++) {
+            PyObject* result;
+
+            if (items[i].mask != NULL) {
+                result = PyBytes_FromStringAndSize(items[i].mask, items[i].alignmentLength);
+            }
+            else {
+                result = PyLong_FromLong(items[i].errorCode);
+            }
+
+            if (result == NULL) {
+                Py_CLEAR(masks);
+                break;
+            }
+
+            PyList_SET_ITEM(masks, i, result);
+        }
+    }
+
+    for (int i = 0; i < itemCount; i++) {
+        free(items[i].mask);
+    }
+
+cleanup:
+    for (int i = 0; i < itemCount && fileNames != NULL; i++) {
+        Py_XDECREF(fileNames[i]);
+    }
+
+    for (int i = 0; i < acquiredBuffers; i++) {
+        if (buffers[i].obj != NULL) {
+            PyBuffer_Release(&buffers[i]);
+        }
+    }
+
+    PyMem_Free(items);
+    PyMem_Free(fileNames);
+    PyMem_Free(buffers);
+    Py_DECREF(alignments);
+
+    return masks;
+}
+
+static PyMethodDef alifilter_native_methods[] = {
+    { "getAlignmentFeatures", alifilter_native_getAlignmentFeatures, METH_VARARGS, alifilter_native_getAlignmentFeatures_doc },
+    { "getScores", alifilter_native_getScores, METH_VARARGS, alifilter_native_getScores_doc },
+    { "getMask", alifilter_native_getMask, METH_VARARGS, alifilter_native_getMask_doc },
+    { "getMasks", alifilter_native_getMasks, METH_VARARGS, alifilter_native_getMasks_doc },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef alifilter_native_module = {
+    PyModuleDef_HEAD_INIT,
+    "_alifilter",
+    "Native implementation of the AliFilter API.",
+    -1,
+    alifilter_native_methods,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+PyMODINIT_FUNC PyInit__alifilter(void) {
+    return PyModule_Create(&alifilter_native_module);
+}
@@ -0,0 +1,31 @@
+#    AliFilter: A Machine Learning Approach to Alignment Filtering
+#
+#    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+#
+#    Copyright (C) 2024  Giorgio Bianchini
+#
+#    This program is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, version 3.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Builds the native extension module used by alifilter.py. To build it in place, run:
+#     python setup.py build_ext --inplace
+
+import sys
+from setuptools import setup, Extension
+
+setup(
+    name='alifilter',
+    py_modules=['alifilter'],
+    ext_modules=[Extension('_alifilter', sources=['alifilter_native.c'], include_dirs=['../C'],
+                           extra_compile_args=[] if sys.platform == 'win32' else ['-pthread'],
+                           extra_link_args=[] if sys.platform == 'win32' else ['-pthread'])]
+)
@@ -10,6 +10,32 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// alifilter_rcpp_file_features
+NumericVector alifilter_rcpp_file_features(std::string alignmentFile);
+RcppExport SEXP _alifilter_alifilter_rcpp_file_features(SEXP alignmentFileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type alignmentFile(alignmentFileSEXP);
+    rcpp_result_gen = Rcpp::wrap(alifilter_rcpp_file_features(alignmentFile));
+    return rcpp_result_gen;
+END_RCPP
+}
+// alifilter_rcpp_file_mask
+List alifilter_rcpp_file_mask(std::string alignmentFile, NumericVector coefficients, double intercept, double threshold, std::string outputFile);
+RcppExport SEXP _alifilter_alifilter_rcpp_file_mask(SEXP alignmentFileSEXP, SEXP coefficientsSEXP, SEXP interceptSEXP, SEXP thresholdSEXP, SEXP outputFileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type alignmentFile(alignmentFileSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type coefficients(coefficientsSEXP);
+    Rcpp::traits::input_parameter< double >::type intercept(interceptSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< std::string >::type outputFile(outputFileSEXP);
+    rcpp_result_gen = Rcpp::wrap(alifilter_rcpp_file_mask(alignmentFile, coefficients, intercept, threshold, outputFile));
+    return rcpp_result_gen;
+END_RCPP
+}
 // alifilter_rcpp_features
 NumericVector alifilter_rcpp_features(List seqs);
 RcppExport SEXP _alifilter_alifilter_rcpp_features(SEXP seqsSEXP) {
@@ -21,9 +47,28 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// alifilter_rcpp_batch
+List alifilter_rcpp_batch(List alignments, LogicalVector dnabin, NumericVector coefficients, double intercept, double threshold, int threads);
+RcppExport SEXP _alifilter_alifilter_rcpp_batch(SEXP alignmentsSEXP, SEXP dnabinSEXP, SEXP coefficientsSEXP, SEXP interceptSEXP, SEXP thresholdSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type alignments(alignmentsSEXP);
+    Rcpp::traits::input_parameter< LogicalVector >::type dnabin(dnabinSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type coefficients(coefficientsSEXP);
+    Rcpp::traits::input_parameter< double >::type intercept(interceptSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(alifilter_rcpp_batch(alignments, dnabin, coefficients, intercept, threshold, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_alifilter_alifilter_rcpp_file_features", (DL_FUNC) &_alifilter_alifilter_rcpp_file_features, 1},
+    {"_alifilter_alifilter_rcpp_file_mask", (DL_FUNC) &_alifilter_alifilter_rcpp_file_mask, 5},
     {"_alifilter_alifilter_rcpp_features", (DL_FUNC) &_alifilter_alifilter_rcpp_features, 1},
+    {"_alifilter_alifilter_rcpp_batch", (DL_FUNC) &_alifilter_alifilter_rcpp_batch, 6},
     {NULL, NULL, 0}
 };
 
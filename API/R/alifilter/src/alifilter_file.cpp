@@ -0,0 +1,609 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <Rcpp.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "alifilter_rcpp.h"
+
+using namespace Rcpp;
+
+// A file that has been mapped in memory for reading.
+class alifilter_mappedFile {
+public:
+  // Pointer to the start of the file contents.
+  const char* data;
+
+  // Size of the file, in bytes.
+  size_t size;
+
+  alifilter_mappedFile(const std::string& fileName) : data(NULL), size(0) {
+#ifdef _WIN32
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    mappingHandle = NULL;
+
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+      stop("Could not open file %s!", fileName);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+      CloseHandle(fileHandle);
+      stop("Could not determine the size of file %s!", fileName);
+    }
+
+    size = (size_t)fileSize.QuadPart;
+
+    if (size > 0) {
+      mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+      data = mappingHandle != NULL ? (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+      if (data == NULL) {
+        if (mappingHandle != NULL) {
+          CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+        stop("Could not map file %s in memory!", fileName);
+      }
+    }
+#else
+    fileDescriptor = open(fileName.c_str(), O_RDONLY);
+
+    if (fileDescriptor < 0) {
+      stop("Could not open file %s!", fileName);
+    }
+
+    struct stat fileInfo;
+    if (fstat(fileDescriptor, &fileInfo) != 0) {
+      close(fileDescriptor);
+      stop("Could not determine the size of file %s!", fileName);
+    }
+
+    size = (size_t)fileInfo.st_size;
+
+    if (size > 0) {
+      void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+      if (mapped == MAP_FAILED) {
+        close(fileDescriptor);
+        stop("Could not map file %s in memory!", fileName);
+      }
+
+      // The file is parsed from start to end.
+      madvise(mapped, size, MADV_SEQUENTIAL);
+
+      data = (const char*)mapped;
+    }
+#endif
+  }
+
+  ~alifilter_mappedFile() {
+#ifdef _WIN32
+    if (data != NULL) {
+      UnmapViewOfFile(data);
+      CloseHandle(mappingHandle);
+    }
+    CloseHandle(fileHandle);
+#else
+    if (data != NULL) {
+      munmap((void*)data, size);
+    }
+    close(fileDescriptor);
+#endif
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE fileHandle;
+  HANDLE mappingHandle;
+#else
+  int fileDescriptor;
+#endif
+
+  alifilter_mappedFile(const alifilter_mappedFile&);
+  alifilter_mappedFile& operator=(const alifilter_mappedFile&);
+};
+
+// An alignment that has been parsed from a file.
+struct alifilter_parsedAlignment {
+  // Whether the alignment was read from a FASTA file (true) or a PHYLIP file (false).
+  bool fasta;
+
+  // Sequence names.
+  std::vector<std::string> sequenceNames;
+
+  // Alignment sequence data (contains sequenceCount * alignmentLength elements).
+  std::vector<unsigned char> sequenceData;
+
+  // Number of sequences in the alignment.
+  int sequenceCount;
+
+  // Length of the alignment.
+  int alignmentLength;
+};
+
+static inline bool alifilter_isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Splits a file that has been mapped in memory into lines. This is shared by the FASTA and PHYLIP parsers.
+struct alifilter_lineReader {
+  const char* data;
+  size_t size;
+  size_t pos;
+
+  alifilter_lineReader(const char* data, size_t size, size_t pos) : data(data), size(size), pos(pos) { }
+
+  // Gets the next line (without the line terminator). Returns false if the end of the data has been reached.
+  bool nextLine(const char*& out_line, size_t& out_length) {
+    if (pos >= size) {
+      return false;
+    }
+
+    const char* lineEnd = (const char*)memchr(data + pos, '\n', size - pos);
+    size_t end = lineEnd != NULL ? lineEnd - data : size;
+
+    out_line = data + pos;
+    out_length = end - pos;
+
+    pos = lineEnd != NULL ? end + 1 : size;
+    return true;
+  }
+};
+
+// Counts the residues (i.e., the characters that are not white space) in a line.
+static size_t alifilter_countResidues(const char* line, size_t length) {
+  size_t count = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    if (!alifilter_isSpace(line[i])) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+// Copies the residues in a line, skipping white space (runs of residues are copied in one go).
+//   Return value: a pointer to the position after the last residue that has been copied.
+static unsigned char* alifilter_copyResidues(const char* line, size_t length, unsigned char* out_residues) {
+  size_t i = 0;
+
+  while (i < length) {
+    while (i < length && alifilter_isSpace(line[i])) {
+      i++;
+    }
+
+    size_t runStart = i;
+
+    while (i < length && !alifilter_isSpace(line[i])) {
+      i++;
+    }
+
+    memcpy(out_residues, line + runStart, i - runStart);
+    out_residues += i - runStart;
+  }
+
+  return out_residues;
+}
+
+// Returns true if a line only contains white space.
+static bool alifilter_isBlank(const char* line, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (!alifilter_isSpace(line[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Parses an alignment in FASTA format. The file is read twice: the first pass determines the number of sequences and
+// the alignment length, and the second pass copies the sequence data into a buffer of the right size.
+static void alifilter_parseFASTA(const char* data, size_t size, alifilter_parsedAlignment& out_alignment) {
+  out_alignment.fasta = true;
+
+  const char* line;
+  size_t length;
+
+  // First pass: count the sequences and check that they all have the same length.
+  long long sequenceCount = 0;
+  long long alignmentLength = -1;
+  long long currLength = 0;
+
+  alifilter_lineReader reader(data, size, 0);
+
+  while (reader.nextLine(line, length)) {
+    if (length > 0 && line[0] == '>') {
+      if (sequenceCount > 0) {
+        if (alignmentLength < 0) {
+          alignmentLength = currLength;
+        }
+        else if (currLength != alignmentLength) {
+          stop("The sequences do not all have the same length!");
+        }
+      }
+
+      sequenceCount++;
+      currLength = 0;
+    }
+    else {
+      currLength += alifilter_countResidues(line, length);
+    }
+  }
+
+  if (alignmentLength < 0) {
+    alignmentLength = currLength;
+  }
+  else if (currLength != alignmentLength) {
+    stop("The sequences do not all have the same length!");
+  }
+
+  if (sequenceCount >= INT_MAX || alignmentLength >= INT_MAX) {
+    stop("The alignment is too large!");
+  }
+
+  out_alignment.sequenceCount = (int)sequenceCount;
+  out_alignment.alignmentLength = (int)alignmentLength;
+  out_alignment.sequenceNames.resize(sequenceCount);
+  out_alignment.sequenceData.resize((size_t)sequenceCount * alignmentLength);
+
+  // Second pass: copy the sequence names and data.
+  int currSequence = -1;
+  unsigned char* sequence = NULL;
+
+  reader = alifilter_lineReader(data, size, 0);
+
+  while (reader.nextLine(line, length)) {
+    if (length > 0 && line[0] == '>') {
+      size_t nameEnd = length;
+
+      while (nameEnd > 1 && alifilter_isSpace(line[nameEnd - 1])) {
+        nameEnd--;
+      }
+
+      currSequence++;
+      out_alignment.sequenceNames[currSequence] = std::string(line + 1, nameEnd - 1);
+      sequence = &out_alignment.sequenceData[(size_t)currSequence * alignmentLength];
+    }
+    else {
+      sequence = alifilter_copyResidues(line, length, sequence);
+    }
+  }
+}
+
+// Reads a non-negative integer, returning -1 if there is no valid integer at the current position.
+static long long alifilter_readInteger(const char* data, size_t size, size_t& pos) {
+  while (pos < size && alifilter_isSpace(data[pos])) {
+    pos++;
+  }
+
+  if (pos >= size || data[pos] < '0' || data[pos] > '9') {
+    return -1;
+  }
+
+  long long value = 0;
+
+  while (pos < size && data[pos] >= '0' && data[pos] <= '9' && value < INT_MAX) {
+    value = value * 10 + (data[pos] - '0');
+    pos++;
+  }
+
+  return value;
+}
+
+// Gets the next line that is not blank. Returns false if the end of the data has been reached.
+static bool alifilter_nextDataLine(alifilter_lineReader& reader, const char*& out_line, size_t& out_length) {
+  while (reader.nextLine(out_line, out_length)) {
+    if (!alifilter_isBlank(out_line, out_length)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Reads the sequence name at the start of a PHYLIP line (up to the first white space), and moves the line pointer to
+// the residues that follow it.
+static std::string alifilter_readPHYLIPName(const char*& line, size_t& length) {
+  size_t start = 0;
+
+  while (start < length && alifilter_isSpace(line[start])) {
+    start++;
+  }
+
+  size_t end = start;
+
+  while (end < length && !alifilter_isSpace(line[end])) {
+    end++;
+  }
+
+  std::string name(line + start, end - start);
+
+  line += end;
+  length -= end;
+
+  return name;
+}
+
+// Appends the residues in a line to a sequence, unless this would make the sequence longer than the alignment.
+//   Return value: false if the line contains too many residues.
+static bool alifilter_appendResidues(const char* line, size_t length, alifilter_parsedAlignment& alignment, int sequence, std::vector<int>& sequenceLengths) {
+  size_t residues = alifilter_countResidues(line, length);
+
+  if (sequenceLengths[sequence] + residues > (size_t)alignment.alignmentLength) {
+    return false;
+  }
+
+  alifilter_copyResidues(line, length, &alignment.sequenceData[(size_t)sequence * alignment.alignmentLength + sequenceLengths[sequence]]);
+  sequenceLengths[sequence] += (int)residues;
+
+  return true;
+}
+
+// Reads the sequences of a PHYLIP file in sequential format (each sequence starts on a new line, with its name, and
+// may continue on the following lines).
+//   Return value: false if the data are not in sequential format.
+static bool alifilter_parsePHYLIPSequential(alifilter_lineReader reader, alifilter_parsedAlignment& out_alignment) {
+  std::vector<int> sequenceLengths(out_alignment.sequenceCount, 0);
+  const char* line;
+  size_t length;
+
+  for (int i = 0; i < out_alignment.sequenceCount; i++) {
+    if (!alifilter_nextDataLine(reader, line, length)) {
+      return false;
+    }
+
+    out_alignment.sequenceNames[i] = alifilter_readPHYLIPName(line, length);
+
+    if (!alifilter_appendResidues(line, length, out_alignment, i, sequenceLengths)) {
+      return false;
+    }
+
+    while (sequenceLengths[i] < out_alignment.alignmentLength) {
+      if (!alifilter_nextDataLine(reader, line, length) || !alifilter_appendResidues(line, length, out_alignment, i, sequenceLengths)) {
+        return false;
+      }
+    }
+  }
+
+  // There should be nothing after the last sequence.
+  return !alifilter_nextDataLine(reader, line, length);
+}
+
+// Reads the sequences of a PHYLIP file in interleaved format (the first block contains one line for each sequence,
+// starting with its name; the following blocks contain one line for each sequence, without the name). All the lines in
+// a block should contain the same number of residues; this is what distinguishes an interleaved file from a sequential
+// file in which the sequences span multiple lines.
+//   Return value: false if the data are not in interleaved format.
+static bool alifilter_parsePHYLIPInterleaved(alifilter_lineReader reader, alifilter_parsedAlignment& out_alignment) {
+  std::vector<int> sequenceLengths(out_alignment.sequenceCount, 0);
+  const char* line;
+  size_t length;
+
+  for (int block = 0; sequenceLengths[0] < out_alignment.alignmentLength; block++) {
+    for (int i = 0; i < out_alignment.sequenceCount; i++) {
+      if (!alifilter_nextDataLine(reader, line, length)) {
+        return false;
+      }
+
+      if (block == 0) {
+        out_alignment.sequenceNames[i] = alifilter_readPHYLIPName(line, length);
+      }
+
+      if (!alifilter_appendResidues(line, length, out_alignment, i, sequenceLengths) || sequenceLengths[i] != sequenceLengths[0]) {
+        return false;
+      }
+    }
+  }
+
+  // There should be nothing after the last block.
+  return !alifilter_nextDataLine(reader, line, length);
+}
+
+// Parses an alignment in relaxed PHYLIP format (sequential or interleaved).
+static void alifilter_parsePHYLIP(const char* data, size_t size, alifilter_parsedAlignment& out_alignment) {
+  out_alignment.fasta = false;
+
+  size_t pos = 0;
+
+  long long sequenceCount = alifilter_readInteger(data, size, pos);
+  long long alignmentLength = alifilter_readInteger(data, size, pos);
+
+  if (sequenceCount < 2 || alignmentLength < 1 || sequenceCount >= INT_MAX || alignmentLength >= INT_MAX) {
+    stop("Error while retrieving the number of sequences and the length of the alignment!");
+  }
+
+  out_alignment.sequenceCount = (int)sequenceCount;
+  out_alignment.alignmentLength = (int)alignmentLength;
+  out_alignment.sequenceNames.resize(sequenceCount);
+  out_alignment.sequenceData.resize((size_t)sequenceCount * alignmentLength);
+
+  // The sequences start on the line after the header.
+  alifilter_lineReader reader(data, size, pos);
+  const char* line;
+  size_t length;
+  reader.nextLine(line, length);
+
+  // A file in which each sequence is on a single line is valid in both formats (and is read in the same way).
+  if (!alifilter_parsePHYLIPInterleaved(reader, out_alignment) && !alifilter_parsePHYLIPSequential(reader, out_alignment)) {
+    stop("Error while reading the alignment (the file is neither in sequential nor in interleaved PHYLIP format)!");
+  }
+}
+
+// Reads an alignment in FASTA or PHYLIP format from a file.
+static void alifilter_readAlignmentFile(const std::string& alignmentFile, alifilter_parsedAlignment& out_alignment) {
+  alifilter_mappedFile file(alignmentFile);
+
+  size_t pos = 0;
+  while (pos < file.size && alifilter_isSpace(file.data[pos])) {
+    pos++;
+  }
+
+  if (pos >= file.size) {
+    stop("The alignment file is empty!");
+  }
+
+  if (file.data[pos] == '>') {
+    alifilter_parseFASTA(file.data + pos, file.size - pos, out_alignment);
+  }
+  else {
+    alifilter_parsePHYLIP(file.data + pos, file.size - pos, out_alignment);
+  }
+
+  if (out_alignment.sequenceCount < 1 || out_alignment.alignmentLength < 1) {
+    stop("The alignment file does not contain any sequences!");
+  }
+}
+
+// Wraps the parsed sequence data for the feature computation.
+static alifilter_alignmentData alifilter_getParsedAlignmentData(const alifilter_parsedAlignment& alignment) {
+  alifilter_alignmentData tbr;
+
+  tbr.alignmentLength = alignment.alignmentLength;
+  tbr.columnStride = 1;
+  tbr.translation = NULL;
+  tbr.sequences.resize(alignment.sequenceCount);
+
+  for (int i = 0; i < alignment.sequenceCount; i++) {
+    tbr.sequences[i] = &alignment.sequenceData[(size_t)i * alignment.alignmentLength];
+  }
+
+  return tbr;
+}
+
+// Writes the columns of the alignment that are preserved by the mask, using the same format as the input file.
+static void alifilter_writeFilteredAlignment(const alifilter_parsedAlignment& alignment, const std::string& mask, const std::string& outputFile) {
+  FILE* fileH = fopen(outputFile.c_str(), "w");
+  if (fileH == NULL) {
+    stop("Could not open file %s for writing!", outputFile);
+  }
+
+  std::vector<int> preservedColumns;
+  for (int i = 0; i < alignment.alignmentLength; i++) {
+    if (mask[i] == '1') {
+      preservedColumns.push_back(i);
+    }
+  }
+
+  size_t maxNameLength = 0;
+  for (int i = 0; i < alignment.sequenceCount; i++) {
+    maxNameLength = MAX(maxNameLength, alignment.sequenceNames[i].size());
+  }
+
+  if (!alignment.fasta) {
+    fprintf(fileH, "%d  %d\n", alignment.sequenceCount, (int)preservedColumns.size());
+  }
+
+  std::string line;
+  line.reserve(maxNameLength + preservedColumns.size() + 3);
+
+  for (int i = 0; i < alignment.sequenceCount; i++) {
+    line.clear();
+
+    if (alignment.fasta) {
+      line += '>';
+      line += alignment.sequenceNames[i];
+      line += '\n';
+    }
+    else {
+      line += alignment.sequenceNames[i];
+      line.append(maxNameLength - alignment.sequenceNames[i].size() + 1, ' ');
+    }
+
+    const unsigned char* sequence = &alignment.sequenceData[(size_t)i * alignment.alignmentLength];
+    for (size_t j = 0; j < preservedColumns.size(); j++) {
+      line += (char)sequence[preservedColumns[j]];
+    }
+    line += '\n';
+
+    if (fwrite(line.data(), 1, line.size(), fileH) != line.size()) {
+      fclose(fileH);
+      stop("Error while writing file %s!", outputFile);
+    }
+  }
+
+  if (fclose(fileH) != 0) {
+    stop("Error while closing file %s!", outputFile);
+  }
+}
+
+// Computes the alignment features for an alignment file, without creating any R object for the sequences.
+//   Parameters:
+//     • std::string alignmentFile: path to the alignment file (FASTA or relaxed PHYLIP, sequential or interleaved).
+//
+//   Return value: a matrix containing the features for each alignment column.
+// [[Rcpp::export]]
+NumericVector alifilter_rcpp_file_features(std::string alignmentFile) {
+  alifilter_parsedAlignment alignment;
+  alifilter_readAlignmentFile(alignmentFile, alignment);
+
+  NumericVector features(Dimension(ALIFILTER_FEATURE_COUNT, alignment.alignmentLength));
+  alifilter_getAlignmentFeatures(alifilter_getParsedAlignmentData(alignment), &features[0]);
+  return features;
+}
+
+// Computes the column scores and the mask for an alignment file, optionally writing the filtered alignment to disk.
+//   Parameters:
+//     • std::string alignmentFile: path to the alignment file (FASTA or relaxed PHYLIP, sequential or interleaved).
+//     • NumericVector coefficients: the coefficients of the logistic model.
+//     • double intercept: the intercept of the logistic model.
+//     • double threshold: the threshold used to create the mask.
+//     • std::string outputFile: path to the output file for the filtered alignment (an empty string to skip writing it).
+//
+//   Return value: a list containing the column scores ("scores") and the mask ("mask").
+// [[Rcpp::export]]
+List alifilter_rcpp_file_mask(std::string alignmentFile, NumericVector coefficients, double intercept, double threshold, std::string outputFile) {
+  if (coefficients.size() != ALIFILTER_FEATURE_COUNT) {
+    stop("The model should contain %d coefficients!", ALIFILTER_FEATURE_COUNT);
+  }
+
+  alifilter_parsedAlignment alignment;
+  alifilter_readAlignmentFile(alignmentFile, alignment);
+
+  std::vector<double> features((size_t)ALIFILTER_FEATURE_COUNT * alignment.alignmentLength);
+  alifilter_getAlignmentFeatures(alifilter_getParsedAlignmentData(alignment), features.data());
+
+  NumericVector scores(alignment.alignmentLength);
+  alifilter_getScores(coefficients.begin(), intercept, features.data(), alignment.alignmentLength, scores.begin());
+
+  std::string mask(alignment.alignmentLength, '0');
+  alifilter_getMask(scores.begin(), alignment.alignmentLength, threshold, &mask[0]);
+
+  if (!outputFile.empty()) {
+    alifilter_writeFilteredAlignment(alignment, mask, outputFile);
+  }
+
+  return List::create(Named("scores") = scores, Named("mask") = mask);
+}
@@ -23,30 +23,206 @@
 #include <math.h>
 #include <string.h>
 
-#define MAX(x, y) (((x) > (y)) ? (x) : (y))
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
-#define ALIFILTER_FEATURE_COUNT 6
+#include "alifilter_rcpp.h"
 
 using namespace Rcpp;
 
-void alifilter_getAlignmentFeatures(List sequenceData, double * out_features);
+alifilter_alignmentData alifilter_extractAlignmentData(SEXP alignment, bool dnabin);
+
+// Converts the bit-level coding used by ape for DNAbin objects into upper case ASCII characters.
+static unsigned char alifilter_dnabinTranslation[256];
+
+// Initialises the DNAbin translation table.
+static bool alifilter_initDnabinTranslation() {
+  memset(alifilter_dnabinTranslation, '?', sizeof(alifilter_dnabinTranslation));
+
+  alifilter_dnabinTranslation[136] = 'A';
+  alifilter_dnabinTranslation[72] = 'G';
+  alifilter_dnabinTranslation[40] = 'C';
+  alifilter_dnabinTranslation[24] = 'T';
+  alifilter_dnabinTranslation[192] = 'R';
+  alifilter_dnabinTranslation[160] = 'M';
+  alifilter_dnabinTranslation[144] = 'W';
+  alifilter_dnabinTranslation[96] = 'S';
+  alifilter_dnabinTranslation[80] = 'K';
+  alifilter_dnabinTranslation[48] = 'Y';
+  alifilter_dnabinTranslation[224] = 'V';
+  alifilter_dnabinTranslation[176] = 'H';
+  alifilter_dnabinTranslation[208] = 'D';
+  alifilter_dnabinTranslation[112] = 'B';
+  alifilter_dnabinTranslation[240] = 'N';
+  alifilter_dnabinTranslation[4] = '-';
+  alifilter_dnabinTranslation[2] = '?';
+
+  return true;
+}
+
+static bool alifilter_dnabinTranslationInitialised = alifilter_initDnabinTranslation();
 
 // [[Rcpp::export]]
 NumericVector alifilter_rcpp_features(List seqs) {
   NumericVector features(Dimension(ALIFILTER_FEATURE_COUNT, ((RawVector)seqs[0]).size()));
-  alifilter_getAlignmentFeatures(seqs, &features[0]);
+  alifilter_getAlignmentFeatures(alifilter_extractAlignmentData(seqs, false), &features[0]);
   return features;
 }
 
+// Computes the column scores and masks for a list of alignments, processing the alignments in parallel.
+//   Parameters:
+//     • List alignments: the alignments (each one either a list of raw vectors or a raw matrix).
+//     • LogicalVector dnabin: for each alignment, whether it uses the DNAbin coding (TRUE) or ASCII characters (FALSE).
+//     • NumericVector coefficients: the coefficients of the logistic model.
+//     • double intercept: the intercept of the logistic model.
+//     • double threshold: the threshold used to create the masks.
+//     • int threads: the number of threads to use (0 to use all available cores).
+//
+//   Return value: a list containing the column scores ("scores", a list of numeric vectors) and the masks ("masks", a
+//                 character vector) for each alignment.
+// [[Rcpp::export]]
+List alifilter_rcpp_batch(List alignments, LogicalVector dnabin, NumericVector coefficients, double intercept, double threshold, int threads) {
+  int alignmentCount = alignments.size();
+
+  if (coefficients.size() != ALIFILTER_FEATURE_COUNT) {
+    stop("The model should contain %d coefficients!", ALIFILTER_FEATURE_COUNT);
+  }
+
+  // Everything that requires the R API (accessing the sequence data and allocating the results) happens on this thread.
+  std::vector<alifilter_alignmentData> data(alignmentCount);
+  std::vector<double*> scorePointers(alignmentCount);
+  List scores(alignmentCount);
+
+  for (int i = 0; i < alignmentCount; i++) {
+    data[i] = alifilter_extractAlignmentData(alignments[i], dnabin[i]);
+
+    NumericVector currScores(data[i].alignmentLength);
+    scorePointers[i] = currScores.begin();
+    scores[i] = currScores;
+  }
+
+  std::vector<std::string> masks(alignmentCount);
+  std::vector<double> modelCoefficients(coefficients.begin(), coefficients.end());
+
+  if (threads <= 0) {
+    threads = MAX((int)std::thread::hardware_concurrency(), 1);
+  }
+
+  threads = MIN(threads, MAX(alignmentCount, 1));
+
+  // Each worker takes the next unprocessed alignment until there are none left. The threads are created for this call
+  // and joined before it returns (the persistent pool in alifilter_threads.h is not used, as the package must be
+  // self-contained; starting the threads once per batch of alignments is cheap compared to processing them).
+  std::atomic<int> nextAlignment(0);
+
+  auto worker = [&]() {
+    std::vector<double> features;
+
+    for (int i = nextAlignment++; i < alignmentCount; i = nextAlignment++) {
+      int alignmentLength = data[i].alignmentLength;
+
+      features.resize((size_t)ALIFILTER_FEATURE_COUNT * alignmentLength);
+      alifilter_getAlignmentFeatures(data[i], features.data());
+
+      alifilter_getScores(modelCoefficients.data(), intercept, features.data(), alignmentLength, scorePointers[i]);
+
+      masks[i].resize(alignmentLength);
+      alifilter_getMask(scorePointers[i], alignmentLength, threshold, &masks[i][0]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads; i++) {
+    workers.emplace_back(worker);
+  }
+
+  worker();
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+
+  CharacterVector maskStrings(alignmentCount);
+  for (int i = 0; i < alignmentCount; i++) {
+    maskStrings[i] = masks[i];
+  }
+
+  return List::create(Named("scores") = scores, Named("masks") = maskStrings);
+}
+
+// Extracts pointers to the sequence data of an alignment.
+//   Parameters:
+//     • SEXP alignment: the alignment, either as a list of raw vectors (one per sequence) or as a raw matrix (with one
+//                       row per sequence).
+//     • bool dnabin: whether the raw bytes use the DNAbin coding (true) or are ASCII characters (false).
+//
+//   Return value: an alifilter_alignmentData struct pointing to the sequence data, which remains valid as long as the
+//                 alignment object is protected.
+alifilter_alignmentData alifilter_extractAlignmentData(SEXP alignment, bool dnabin) {
+  alifilter_alignmentData tbr;
+  tbr.translation = dnabin ? alifilter_dnabinTranslation : NULL;
+
+  if (TYPEOF(alignment) == RAWSXP) {
+    RawMatrix matrix(alignment);
+    int sequenceCount = matrix.nrow();
+
+    if (sequenceCount == 0) {
+      stop("The alignment does not contain any sequences!");
+    }
+
+    tbr.alignmentLength = matrix.ncol();
+    tbr.columnStride = sequenceCount;
+    tbr.sequences.resize(sequenceCount);
+
+    for (int i = 0; i < sequenceCount; i++) {
+      tbr.sequences[i] = RAW(alignment) + i;
+    }
+  }
+  else if (TYPEOF(alignment) == VECSXP) {
+    List sequences(alignment);
+    int sequenceCount = sequences.size();
+
+    if (sequenceCount == 0) {
+      stop("The alignment does not contain any sequences!");
+    }
+
+    tbr.alignmentLength = Rf_xlength(sequences[0]);
+    tbr.columnStride = 1;
+    tbr.sequences.resize(sequenceCount);
+
+    for (int i = 0; i < sequenceCount; i++) {
+      SEXP sequence = sequences[i];
+
+      if (TYPEOF(sequence) != RAWSXP || Rf_xlength(sequence) != tbr.alignmentLength) {
+        stop("The sequences do not all have the same length!");
+      }
+
+      tbr.sequences[i] = RAW(sequence);
+    }
+  }
+  else {
+    stop("Invalid alignment data!");
+  }
+
+  return tbr;
+}
+
 // Computes features for a single column.
-void alifilter_computeColumnFeatures(List sequenceData, int sequenceCount, int alignmentLength, int column, double * out_features) {
+void alifilter_computeColumnFeatures(const alifilter_alignmentData& sequenceData, int sequenceCount, int alignmentLength, int column, double * out_features) {
   int gapCount = 0;
   int counts['Z' - 'A' + 1] = { 0 };
   int validChars = 0;
 
+  size_t offset = (size_t)column * sequenceData.columnStride;
+
   for (int i = 0; i < sequenceCount; i++) {
-    unsigned char c = ((RawVector)sequenceData[i])[column];
+    unsigned char c = sequenceData.sequences[i][offset];
+
+    if (sequenceData.translation != NULL) {
+      c = sequenceData.translation[c];
+    }
 
     if (c == '-') {
       gapCount++;
@@ -59,7 +235,6 @@ void alifilter_computeColumnFeatures(List sequenceData, int sequenceCount, int a
       }
     }
   }
-
   // % Gaps
   out_features[0] = (double)gapCount / sequenceCount;
 
@@ -91,14 +266,9 @@ void alifilter_computeColumnFeatures(List sequenceData, int sequenceCount, int a
   // % Gaps +- 1 and % Gaps +- 2 are not computed here.
 }
 
-// Computes the alignment features for an alignment.
-//   Parameters:
-//     • List sequenceData: the alignment sequence data.
-//     • double * out_features: the computed features will be stored at this pointer
-//                              The pointer should be able to address at least ALIFILTER_FEATURE_COUNT * <alignment length> values.
-void alifilter_getAlignmentFeatures(List sequenceData, double * out_features) {
-  int sequenceCount = sequenceData.size();
-  int alignmentLength = ((RawVector)sequenceData[0]).size();
+void alifilter_getAlignmentFeatures(const alifilter_alignmentData& sequenceData, double * out_features) {
+  int sequenceCount = sequenceData.sequences.size();
+  int alignmentLength = sequenceData.alignmentLength;
 
   // Compute % Gaps, % Identity, Distance from extremity and Entropy.
   for (int i = 0; i < alignmentLength; i++) {
@@ -122,3 +292,19 @@ void alifilter_getAlignmentFeatures(List sequenceData, double * out_features) {
                                                     (1 + (i > 1 ? 2 : i > 0 ? 1 : 0) + (i < alignmentLength - 2 ? 2 : i < alignmentLength - 1 ? 1 : 0));
   }
 }
+
+void alifilter_getScores(const double * coefficients, double intercept, const double * features, int alignmentLength, double * out_scores) {
+  for (int i = 0; i < alignmentLength; i++) {
+    double score = intercept;
+    for (int j = 0; j < ALIFILTER_FEATURE_COUNT; j++) {
+      score += features[(size_t)i * ALIFILTER_FEATURE_COUNT + j] * coefficients[j];
+    }
+    out_scores[i] = 1.0 / (1.0 + exp(-score));
+  }
+}
+
+void alifilter_getMask(const double * scores, int alignmentLength, double threshold, char * out_mask) {
+  for (int i = 0; i < alignmentLength; i++) {
+    out_mask[i] = scores[i] >= threshold ? '1' : '0';
+  }
+}
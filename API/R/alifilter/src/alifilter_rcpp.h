@@ -0,0 +1,75 @@
+/*
+    AliFilter: A Machine Learning Approach to Alignment Filtering
+
+    by Giorgio Bianchini, Rui Zhu, Francesco Cicconardi, Edmund RR Moody
+
+    Copyright (C) 2024  Giorgio Bianchini
+ 
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALIFILTER_RCPP_H
+#define ALIFILTER_RCPP_H
+
+#include <vector>
+
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define ALIFILTER_FEATURE_COUNT 6
+
+// Pointers to the sequence data of an alignment that has been extracted from the R objects, so that it can be
+// accessed without calling into R (e.g., from a worker thread).
+struct alifilter_alignmentData {
+  // Pointer to the first residue of each sequence.
+  std::vector<const unsigned char*> sequences;
+
+  // Distance between consecutive residues of the same sequence (1 for a list of sequences, the number of sequences
+  // for a matrix).
+  int columnStride;
+
+  // Length of the alignment.
+  int alignmentLength;
+
+  // Table used to convert the raw bytes to ASCII characters (NULL if the bytes are already ASCII characters).
+  const unsigned char* translation;
+};
+
+// Computes the alignment features for an alignment.
+//   Parameters:
+//     • const alifilter_alignmentData& sequenceData: the alignment sequence data.
+//     • double * out_features: the computed features will be stored at this pointer
+//                              The pointer should be able to address at least ALIFILTER_FEATURE_COUNT * <alignment length> values.
+void alifilter_getAlignmentFeatures(const alifilter_alignmentData& sequenceData, double * out_features);
+
+// Computes the column scores from pre-computed alignment features.
+//   Parameters:
+//     • const double * coefficients: the ALIFILTER_FEATURE_COUNT coefficients of the logistic model.
+//     • double intercept: the intercept of the logistic model.
+//     • const double * features: the alignment features (ALIFILTER_FEATURE_COUNT * alignmentLength values).
+//     • int alignmentLength: the number of alignment columns.
+//     • double * out_scores: the computed scores will be stored at this pointer, which should be able to address at
+//                            least alignmentLength values.
+void alifilter_getScores(const double * coefficients, double intercept, const double * features, int alignmentLength, double * out_scores);
+
+// Computes the mask from pre-computed column scores (columns whose score is greater than or equal to the threshold are
+// preserved).
+//   Parameters:
+//     • const double * scores: the column scores (alignmentLength values).
+//     • int alignmentLength: the number of alignment columns.
+//     • double threshold: the threshold used to create the mask.
+//     • char * out_mask: the mask (a '1' or '0' for each column) will be stored at this pointer, which should be able to
+//                        address at least alignmentLength values. No string terminator is added.
+void alifilter_getMask(const double * scores, int alignmentLength, double threshold, char * out_mask);
+
+#endif